@@ -0,0 +1,351 @@
+// Сравнение скорости разбора JSON из непрерывного буфера с прежней загрузкой
+// через std::istream. Без аргументов разбирается синтетический набор
+// base_requests, иначе - документ из указанного файла
+#include "json.h"
+#include "json_flat.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+using namespace std::literals;
+
+namespace legacy {
+
+    // Загрузка в том виде, в каком она была до разбора по буферу: по одному
+    // символу через operator>>, peek и putback, числа через std::stoi/std::stod
+    json::Node LoadNode(std::istream& input);
+    json::Node LoadString(std::istream& input);
+
+    std::string LoadLiteral(std::istream& input) {
+        std::string s;
+        while (std::isalpha(input.peek())) {
+            s.push_back(static_cast<char>(input.get()));
+        }
+        return s;
+    }
+
+    json::Node LoadArray(std::istream& input) {
+        std::vector<json::Node> result;
+
+        for (char c; input >> c && c != ']';) {
+            if (c != ',') {
+                input.putback(c);
+            }
+            result.push_back(LoadNode(input));
+        }
+        if (!input) {
+            throw json::ParsingError("Array parsing error"s);
+        }
+        return json::Node(std::move(result));
+    }
+
+    json::Node LoadDict(std::istream& input) {
+        json::Dict dict;
+
+        for (char c; input >> c && c != '}';) {
+            if (c == '"') {
+                std::string key = LoadString(input).AsString();
+                if (input >> c && c == ':') {
+                    if (dict.find(key) != dict.end()) {
+                        throw json::ParsingError("Duplicate key '"s + key + "' have been found");
+                    }
+                    dict.emplace(std::move(key), LoadNode(input));
+                }
+                else {
+                    throw json::ParsingError(": is expected but '"s + c + "' has been found"s);
+                }
+            }
+            else if (c != ',') {
+                throw json::ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
+        }
+        if (!input) {
+            throw json::ParsingError("Dictionary parsing error"s);
+        }
+        return json::Node(std::move(dict));
+    }
+
+    json::Node LoadString(std::istream& input) {
+        auto it = std::istreambuf_iterator<char>(input);
+        auto end = std::istreambuf_iterator<char>();
+        std::string s;
+        while (true) {
+            if (it == end) {
+                throw json::ParsingError("String parsing error");
+            }
+            const char ch = *it;
+            if (ch == '"') {
+                ++it;
+                break;
+            }
+            else if (ch == '\\') {
+                ++it;
+                if (it == end) {
+                    throw json::ParsingError("String parsing error");
+                }
+                const char escaped_char = *(it);
+                switch (escaped_char) {
+                case 'n':
+                    s.push_back('\n');
+                    break;
+                case 't':
+                    s.push_back('\t');
+                    break;
+                case 'r':
+                    s.push_back('\r');
+                    break;
+                case '"':
+                    s.push_back('"');
+                    break;
+                case '\\':
+                    s.push_back('\\');
+                    break;
+                default:
+                    throw json::ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+                }
+            }
+            else if (ch == '\n' || ch == '\r') {
+                throw json::ParsingError("Unexpected end of line"s);
+            }
+            else {
+                s.push_back(ch);
+            }
+            ++it;
+        }
+
+        return json::Node(std::move(s));
+    }
+
+    json::Node LoadBool(std::istream& input) {
+        const auto s = LoadLiteral(input);
+        if (s == "true"sv) {
+            return json::Node{ true };
+        }
+        else if (s == "false"sv) {
+            return json::Node{ false };
+        }
+        else {
+            throw json::ParsingError("Failed to parse '"s + s + "' as bool"s);
+        }
+    }
+
+    json::Node LoadNull(std::istream& input) {
+        if (auto literal = LoadLiteral(input); literal == "null"sv) {
+            return json::Node{ nullptr };
+        }
+        else {
+            throw json::ParsingError("Failed to parse '"s + literal + "' as null"s);
+        }
+    }
+
+    json::Node LoadNumber(std::istream& input) {
+        std::string parsed_num;
+
+        auto read_char = [&parsed_num, &input] {
+            parsed_num += static_cast<char>(input.get());
+            if (!input) {
+                throw json::ParsingError("Failed to read number from stream"s);
+            }
+        };
+
+        auto read_digits = [&input, read_char] {
+            if (!std::isdigit(input.peek())) {
+                throw json::ParsingError("A digit is expected"s);
+            }
+            while (std::isdigit(input.peek())) {
+                read_char();
+            }
+        };
+
+        if (input.peek() == '-') {
+            read_char();
+        }
+        if (input.peek() == '0') {
+            read_char();
+        }
+        else {
+            read_digits();
+        }
+
+        bool is_int = true;
+        if (input.peek() == '.') {
+            read_char();
+            read_digits();
+            is_int = false;
+        }
+
+        if (int ch = input.peek(); ch == 'e' || ch == 'E') {
+            read_char();
+            if (ch = input.peek(); ch == '+' || ch == '-') {
+                read_char();
+            }
+            read_digits();
+            is_int = false;
+        }
+
+        try {
+            if (is_int) {
+                try {
+                    return std::stoi(parsed_num);
+                }
+                catch (...) {
+                }
+            }
+            return std::stod(parsed_num);
+        }
+        catch (...) {
+            throw json::ParsingError("Failed to convert "s + parsed_num + " to number"s);
+        }
+    }
+
+    json::Node LoadNode(std::istream& input) {
+        char c;
+        if (!(input >> c)) {
+            throw json::ParsingError("Unexpected EOF"s);
+        }
+        switch (c) {
+        case '[':
+            return LoadArray(input);
+        case '{':
+            return LoadDict(input);
+        case '"':
+            return LoadString(input);
+        case 't':
+            [[fallthrough]];
+        case 'f':
+            input.putback(c);
+            return LoadBool(input);
+        case 'n':
+            input.putback(c);
+            return LoadNull(input);
+        default:
+            input.putback(c);
+            return LoadNumber(input);
+        }
+    }
+
+    json::Document Load(std::istream& input) {
+        return json::Document{ LoadNode(input) };
+    }
+
+}  // namespace legacy
+
+namespace {
+
+    // Обработчик, который только считает события, чтобы замерить сам разбор
+    class CountingHandler final : public json::Handler {
+    public:
+        void StartObject() override { ++count_; }
+        void Key(std::string_view) override { ++count_; }
+        void EndObject() override { ++count_; }
+        void StartArray() override { ++count_; }
+        void EndArray() override { ++count_; }
+        void Null() override { ++count_; }
+        void Bool(bool) override { ++count_; }
+        void Int(int) override { ++count_; }
+        void Double(double) override { ++count_; }
+        void String(std::string_view) override { ++count_; }
+
+        size_t GetCount() const {
+            return count_;
+        }
+
+    private:
+        size_t count_ = 0;
+    };
+
+    // Запросы base_requests, похожие на настоящие: остановки с координатами
+    // и расстояниями до соседей, маршруты по нескольким десяткам остановок
+    std::string MakeInput(int stop_count, int bus_count) {
+        json::Array requests;
+        for (int i = 0; i < stop_count; ++i) {
+            json::Dict distances;
+            for (int j = 1; j <= 3; ++j) {
+                distances.emplace("Stop "s + std::to_string((i + j * 7) % stop_count), 300 + (i * j) % 4000);
+            }
+            requests.emplace_back(json::Dict{
+                { "type"s, "Stop"s },
+                { "name"s, "Stop "s + std::to_string(i) },
+                { "latitude"s, 55.5 + i % 1000 / 2000.0 },
+                { "longitude"s, 37.3 + i / 1000 / 200.0 },
+                { "road_distances"s, std::move(distances) },
+            });
+        }
+        for (int i = 0; i < bus_count; ++i) {
+            json::Array stops;
+            for (int j = 0; j < 25; ++j) {
+                stops.emplace_back("Stop "s + std::to_string((i * 31 + j * 17) % stop_count));
+            }
+            requests.emplace_back(json::Dict{
+                { "type"s, "Bus"s },
+                { "name"s, "Bus "s + std::to_string(i) },
+                { "stops"s, std::move(stops) },
+                { "is_roundtrip"s, i % 2 == 0 },
+            });
+        }
+        std::string text;
+        json::Print(json::Document{ json::Node{ json::Dict{ { "base_requests"s, std::move(requests) } } } }, text);
+        return text;
+    }
+
+    // Лучшее время из нескольких прогонов, чтобы меньше зависеть от шума
+    template <typename Func>
+    void Measure(std::string_view name, size_t size, Func func) {
+        constexpr int RUNS = 5;
+        double best = 1e9;
+        for (int run = 0; run < RUNS; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            func();
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        std::cout << name << ": "sv << best * 1000 << " ms, "sv << size / 1e6 / best << " MB/s, "sv << size << " bytes"sv << std::endl;
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string text;
+    if (argc > 1) {
+        std::ifstream input(argv[1], std::ios::binary);
+        if (!input) {
+            std::cerr << "Cannot open "sv << argv[1] << std::endl;
+            return 1;
+        }
+        text = json::ReadAll(input);
+    }
+    else {
+        text = MakeInput(50000, 2000);
+    }
+
+    std::istringstream legacy_input(text);
+    if (legacy::Load(legacy_input) != json::Load(std::string_view(text))) {
+        std::cerr << "Buffer parser result differs from the istream loader"sv << std::endl;
+        return 1;
+    }
+
+    Measure("istream loader"sv, text.size(), [&text] {
+        std::istringstream input(text);
+        return legacy::Load(input);
+    });
+    Measure("json::Load from buffer"sv, text.size(), [&text] {
+        return json::Load(std::string_view(text));
+    });
+    Measure("json::FlatBuilder"sv, text.size(), [&text] {
+        json::FlatBuilder builder(text);
+        json::Parse(text, builder);
+        return builder.Extract();
+    });
+    Measure("json::Parse events only"sv, text.size(), [&text] {
+        CountingHandler handler;
+        json::Parse(text, handler);
+        return handler.GetCount();
+    });
+}
\ No newline at end of file
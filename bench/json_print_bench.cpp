@@ -0,0 +1,240 @@
+// Сравнение скорости json::Print с прежней печатью через std::ostream.
+// Без аргументов печатается синтетический набор ответов на stat_requests,
+// иначе - документ из указанного файла
+#include "json.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+using namespace std::literals;
+
+namespace legacy {
+
+    // Печать в том виде, в каком она была до буферизованного вывода:
+    // числа через operator<<, отступы и строки по одному символу
+    struct PrintContext {
+        std::ostream& out;
+        int indent_step = 4;
+        int indent = 0;
+
+        void PrintIndent() const {
+            for (int i = 0; i < indent; ++i) {
+                out.put(' ');
+            }
+        }
+
+        PrintContext Indented() const {
+            return { out, indent_step, indent_step + indent };
+        }
+    };
+
+    void PrintNode(const json::Node& value, const PrintContext& ctx);
+
+    template <typename Value>
+    void PrintValue(const Value& value, const PrintContext& ctx) {
+        ctx.out << value;
+    }
+
+    void PrintString(const std::string& value, std::ostream& out) {
+        out.put('"');
+        for (const char c : value) {
+            switch (c) {
+            case '\r':
+                out << "\\r"sv;
+                break;
+            case '\n':
+                out << "\\n"sv;
+                break;
+            case '\t':
+                out << "\\t"sv;
+                break;
+            case '"':
+                [[fallthrough]];
+            case '\\':
+                out.put('\\');
+                [[fallthrough]];
+            default:
+                out.put(c);
+                break;
+            }
+        }
+        out.put('"');
+    }
+
+    template <>
+    void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
+        PrintString(value, ctx.out);
+    }
+
+    template <>
+    void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
+        ctx.out << "null"sv;
+    }
+
+    template <>
+    void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
+        ctx.out << (value ? "true"sv : "false"sv);
+    }
+
+    template <>
+    void PrintValue<json::RawJson>(const json::RawJson& value, const PrintContext& ctx) {
+        ctx.out << *value.text;
+    }
+
+    template <>
+    void PrintValue<json::Array>(const json::Array& nodes, const PrintContext& ctx) {
+        std::ostream& out = ctx.out;
+        out << "[\n"sv;
+        bool first = true;
+        auto inner_ctx = ctx.Indented();
+        for (const json::Node& node : nodes) {
+            if (first) {
+                first = false;
+            }
+            else {
+                out << ",\n"sv;
+            }
+            inner_ctx.PrintIndent();
+            PrintNode(node, inner_ctx);
+        }
+        out.put('\n');
+        ctx.PrintIndent();
+        out.put(']');
+    }
+
+    template <>
+    void PrintValue<json::Dict>(const json::Dict& nodes, const PrintContext& ctx) {
+        std::ostream& out = ctx.out;
+        out << "{\n"sv;
+        bool first = true;
+        auto inner_ctx = ctx.Indented();
+        for (const auto& [key, node] : nodes) {
+            if (first) {
+                first = false;
+            }
+            else {
+                out << ",\n"sv;
+            }
+            inner_ctx.PrintIndent();
+            PrintString(key, ctx.out);
+            out << ": "sv;
+            PrintNode(node, inner_ctx);
+        }
+        out.put('\n');
+        ctx.PrintIndent();
+        out.put('}');
+    }
+
+    void PrintNode(const json::Node& node, const PrintContext& ctx) {
+        std::visit([&ctx](const auto& value) {
+            PrintValue(value, ctx);
+        }, node.GetValue());
+    }
+
+    void Print(const json::Document& doc, std::ostream& output) {
+        PrintNode(doc.GetRoot(), PrintContext{ output });
+    }
+
+}  // namespace legacy
+
+namespace {
+
+    // Ответы, похожие на ответы на запросы Bus, Stop и Route
+    json::Document MakeResponses(int count) {
+        json::Array responses;
+        for (int i = 0; i < count; ++i) {
+            json::Dict bus{
+                { "request_id"s, i },
+                { "curvature"s, 1.0 + i % 97 / 113.0 },
+                { "route_length"s, 10000 + i * 7 },
+                { "stop_count"s, 5 + i % 40 },
+                { "unique_stop_count"s, 3 + i % 20 },
+            };
+            responses.emplace_back(std::move(bus));
+
+            json::Array buses;
+            for (int j = 0; j < i % 6; ++j) {
+                buses.emplace_back("Bus \"express\" "s + std::to_string(j));
+            }
+            responses.emplace_back(json::Dict{ { "request_id"s, i }, { "buses"s, std::move(buses) } });
+
+            json::Array items;
+            for (int j = 0; j < 4; ++j) {
+                items.emplace_back(json::Dict{
+                    { "type"s, "Bus"s },
+                    { "bus"s, "Route "s + std::to_string(j) },
+                    { "span_count"s, j + 1 },
+                    { "time"s, 3.14159 * (j + 1) + i / 1000.0 },
+                });
+            }
+            responses.emplace_back(json::Dict{
+                { "request_id"s, i },
+                { "total_time"s, 12.5 + i / 7.0 },
+                { "items"s, std::move(items) },
+            });
+        }
+        return json::Document{ json::Node{ std::move(responses) } };
+    }
+
+    // Лучшее время из нескольких прогонов, чтобы меньше зависеть от шума
+    template <typename Func>
+    void Measure(std::string_view name, Func func) {
+        constexpr int RUNS = 5;
+        double best = 1e9;
+        size_t size = 0;
+        for (int run = 0; run < RUNS; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            size = func();
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        std::cout << name << ": "sv << best * 1000 << " ms, "sv << size / 1e6 / best << " MB/s, "sv << size << " bytes"sv << std::endl;
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::optional<json::Document> doc;
+    if (argc > 1) {
+        std::ifstream input(argv[1]);
+        if (!input) {
+            std::cerr << "Cannot open "sv << argv[1] << std::endl;
+            return 1;
+        }
+        doc = json::Load(input);
+    }
+    else {
+        doc = MakeResponses(100000);
+    }
+
+    std::ostringstream legacy_output;
+    legacy::Print(*doc, legacy_output);
+    std::string pretty_output;
+    json::Print(*doc, pretty_output);
+    if (legacy_output.str() != pretty_output) {
+        std::cerr << "PRETTY output differs from the ostream printer"sv << std::endl;
+        return 1;
+    }
+
+    Measure("ostream printer"sv, [&doc] {
+        std::ostringstream output;
+        legacy::Print(*doc, output);
+        return output.str().size();
+    });
+    Measure("json::Print PRETTY"sv, [&doc] {
+        std::string output;
+        json::Print(*doc, output);
+        return output.size();
+    });
+    Measure("json::Print COMPACT"sv, [&doc] {
+        std::string output;
+        json::Print(*doc, output, json::PrintMode::COMPACT);
+        return output.size();
+    });
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+// Замер построения и вывода карты на синтетическом справочнике из 50 000
+// остановок и 2000 маршрутов. Размер и хэш SVG печатаются, чтобы сравнивать
+// вывод разных версий: он должен совпадать байт в байт
+#include "map_renderer.h"
+#include "transport_catalogue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+using namespace std::literals;
+
+namespace {
+
+    constexpr int STOP_COUNT = 50000;
+    constexpr int BUS_COUNT = 2000;
+
+    // Остановки разбросаны по прямоугольнику размером с город, маршруты
+    // проходят через 10-49 случайных остановок, половина из них кольцевые
+    void FillCatalogue(transport_catalogue::TransportCatalogue& catalogue) {
+        std::mt19937 generator(1);
+        std::uniform_real_distribution<double> latitude(55.5, 56.0);
+        std::uniform_real_distribution<double> longitude(37.3, 37.9);
+        for (int i = 0; i < STOP_COUNT; ++i) {
+            catalogue.AddStop("Stop "s + std::to_string(i), { latitude(generator), longitude(generator) });
+        }
+
+        std::vector<const transport_catalogue::Stop*> stops;
+        for (int i = 0; i < BUS_COUNT; ++i) {
+            stops.clear();
+            const int stop_count = 10 + static_cast<int>(generator() % 40);
+            for (int j = 0; j < stop_count; ++j) {
+                stops.push_back(catalogue.GetStop(generator() % STOP_COUNT));
+            }
+            catalogue.AddRoute("Bus "s + std::to_string(i), stops, i % 2 == 1);
+        }
+    }
+
+    renderer::RenderSettings MakeRenderSettings() {
+        renderer::RenderSettings settings;
+        settings.width = 1200.0;
+        settings.height = 1200.0;
+        settings.padding = 50.0;
+        settings.stop_radius = 5.0;
+        settings.line_width = 14.0;
+        settings.bus_label_font_size = 20;
+        settings.bus_label_offset = { 7.0, 15.0 };
+        settings.stop_label_font_size = 20;
+        settings.stop_label_offset = { 7.0, -3.0 };
+        settings.underlayer_color = svg::Rgba(255, 255, 255, 0.85);
+        settings.underlayer_width = 3.0;
+        settings.color_palette = { "green"s, svg::Rgb(255, 160, 0), "red"s };
+        return settings;
+    }
+
+    // Лучшее время из нескольких прогонов, чтобы меньше зависеть от шума
+    template <typename Func>
+    void Measure(std::string_view name, Func func) {
+        constexpr int RUNS = 5;
+        double best = 1e9;
+        for (int run = 0; run < RUNS; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            func();
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        std::cout << name << ": "sv << best * 1000 << " ms"sv << std::endl;
+    }
+
+}  // namespace
+
+int main() {
+    transport_catalogue::TransportCatalogue catalogue;
+    FillCatalogue(catalogue);
+    const renderer::MapRenderer renderer(MakeRenderSettings());
+    const auto buses = catalogue.GetBusesOnStop();
+
+    const svg::Document document = renderer.GetSVG(buses);
+    std::string output;
+    document.Render(output);
+    std::cout << "SVG: "sv << output.size() << " bytes, hash "sv << std::hash<std::string>{}(output) << std::endl;
+
+    Measure("GetSVG"sv, [&] {
+        return renderer.GetSVG(buses);
+    });
+    Measure("Render to std::string"sv, [&] {
+        std::string rendered;
+        document.Render(rendered);
+        return rendered.size();
+    });
+    Measure("Render to std::ostream"sv, [&] {
+        std::ostringstream rendered;
+        document.Render(rendered);
+        return rendered.tellp();
+    });
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+// Клиент для отладки режима --serve транспортного справочника: отправляет
+// строки stdin на Unix-сокет по одной и печатает полученные ответы
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std::literals;
+
+namespace {
+
+    int Connect(const std::string& socket_path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+            std::cerr << "Invalid socket path: "sv << socket_path << std::endl;
+            return -1;
+        }
+        std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+        const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            std::cerr << "socket: "sv << std::strerror(errno) << std::endl;
+            return -1;
+        }
+        if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+            std::cerr << "connect: "sv << std::strerror(errno) << std::endl;
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    bool SendAll(int fd, std::string_view data) {
+        while (!data.empty()) {
+            const ssize_t size = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (size < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data.remove_prefix(static_cast<size_t>(size));
+        }
+        return true;
+    }
+
+    // Читает одну строку ответа; buffer хранит уже принятые, но не выданные байты
+    bool ReceiveLine(int fd, std::string& buffer, std::string& line) {
+        while (true) {
+            if (const size_t end = buffer.find('\n'); end != std::string::npos) {
+                line.assign(buffer, 0, end);
+                buffer.erase(0, end + 1);
+                return true;
+            }
+            char chunk[1 << 16];
+            const ssize_t size = recv(fd, chunk, sizeof(chunk), 0);
+            if (size < 0 && errno == EINTR) {
+                continue;
+            }
+            if (size <= 0) {
+                return false;
+            }
+            buffer.append(chunk, static_cast<size_t>(size));
+        }
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: "sv << argv[0] << " <socket path> < requests.ndjson"sv << std::endl;
+        return 1;
+    }
+
+    const int fd = Connect(argv[1]);
+    if (fd < 0) {
+        return 1;
+    }
+
+    std::string request;
+    std::string response;
+    std::string buffer;
+    while (std::getline(std::cin, request)) {
+        if (request.empty() || request == "\r"sv) {
+            continue;
+        }
+        request += '\n';
+        if (!SendAll(fd, request)) {
+            std::cerr << "send: "sv << std::strerror(errno) << std::endl;
+            close(fd);
+            return 1;
+        }
+        if (!ReceiveLine(fd, buffer, response)) {
+            std::cerr << "Connection closed by server"sv << std::endl;
+            close(fd);
+            return 1;
+        }
+        std::cout << response << '\n';
+    }
+
+    close(fd);
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+// Проверки разбора и загрузки base_requests: неизвестная остановка, нецелое
+// расстояние и запросы с пропущенными или неверно типизированными полями не
+// должны приводить к падению или к тихим значениям по умолчанию
+#include "json_reader.h"
+#include "transport_catalogue.h"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std::literals;
+
+namespace {
+
+    int failures = 0;
+
+    void Check(bool condition, const std::string& message) {
+        if (!condition) {
+            std::cerr << "FAILED: "sv << message << std::endl;
+            ++failures;
+        }
+    }
+
+    template <typename Exception, typename Func>
+    void CheckThrows(Func func, const std::string& message) {
+        try {
+            func();
+        }
+        catch (const Exception&) {
+            return;
+        }
+        catch (...) {
+        }
+        Check(false, message);
+    }
+
+    void TestCatalogueRejectsUnknownStop() {
+        transport_catalogue::TransportCatalogue catalogue;
+        catalogue.AddStop("A"sv, { 55.0, 37.0 });
+        catalogue.AddStop("B"sv, { 55.1, 37.1 });
+        const auto* a = catalogue.FindStop("A"sv);
+        const auto* b = catalogue.FindStop("B"sv);
+        catalogue.AddRoute("1"sv, { a, b }, false);
+
+        CheckThrows<std::invalid_argument>([&] {
+            catalogue.SetDistance(a, catalogue.FindStop("Nowhere"sv), 100);
+        }, "SetDistance with an unknown stop"s);
+        CheckThrows<std::invalid_argument>([&] {
+            catalogue.SetDistances({ { a, b, 100 }, { a, nullptr, 100 } });
+        }, "SetDistances with an unknown stop"s);
+        Check(catalogue.GetDistance(a, b) == 0, "rejected SetDistances must not change the catalogue"s);
+
+        catalogue.SetDistances({ { a, b, 100 } });
+        Check(catalogue.GetDistance(a, b) == 100, "known stops are still accepted"s);
+    }
+
+    std::string MakeInput(const std::string& road_distances) {
+        return R"({"base_requests": [
+            {"type": "Stop", "name": "A", "latitude": 55.0, "longitude": 37.0, "road_distances": )"s + road_distances + R"(},
+            {"type": "Stop", "name": "B", "latitude": 55.01, "longitude": 37.01, "road_distances": {}},
+            {"type": "Bus", "name": "1", "stops": ["A", "B"], "is_roundtrip": false}
+        ]})"s;
+    }
+
+    void TestReaderSkipsUnknownStop() {
+        transport_catalogue::TransportCatalogue catalogue;
+        std::istringstream input(MakeInput(R"({"Nowhere": 100, "B": 1000})"s));
+        JsonReader reader(input, catalogue);
+        const auto* bus = catalogue.FindRoute("1"sv);
+        Check(bus && catalogue.GetBusStat(bus).route_length == 2000, "distance to an unknown stop is skipped"s);
+    }
+
+    void TestReaderRejectsNonIntDistance() {
+        for (const std::string& value : { R"({"B": "far"})"s, R"({"B": 1.5})"s, R"({"B": null})"s, R"([1000])"s }) {
+            transport_catalogue::TransportCatalogue catalogue;
+            std::istringstream input(MakeInput(value));
+            CheckThrows<std::logic_error>([&] {
+                JsonReader reader(input, catalogue);
+            }, "road_distances "s + value + " must be rejected"s);
+        }
+    }
+
+    // Каждый вход проверяется и целиком, и в составе документа с другими
+    // разделами, чтобы пройти и параллельный, и последовательный разбор
+    template <typename Exception>
+    void CheckRejected(const std::string& requests, const std::string& message) {
+        for (const std::string& input : {
+                R"({"base_requests": )"s + requests + "}"s,
+                R"({"render_settings": {}, "base_requests": )"s + requests + R"(, "stat_requests": []})"s }) {
+            transport_catalogue::TransportCatalogue catalogue;
+            std::istringstream stream(input);
+            CheckThrows<Exception>([&] {
+                JsonReader reader(stream, catalogue);
+            }, message + ": "s + input);
+        }
+    }
+
+    void TestReaderRejectsMalformedRequests() {
+        const std::string stop = R"("type": "Stop", "name": "A", "latitude": 55.0, "longitude": 37.0, "road_distances": {})"s;
+        const std::string bus = R"("type": "Bus", "name": "1", "stops": ["A"], "is_roundtrip": true)"s;
+
+        CheckRejected<std::logic_error>(R"({})"s, "base_requests must be an array"s);
+        CheckRejected<std::logic_error>(R"(7)"s, "base_requests must be an array"s);
+        CheckRejected<std::logic_error>(R"(["hello"])"s, "a string request must be rejected"s);
+        CheckRejected<std::logic_error>(R"([7])"s, "a number request must be rejected"s);
+        CheckRejected<std::logic_error>(R"([[]])"s, "an array request must be rejected"s);
+        CheckRejected<std::logic_error>(R"([{)"s + stop + R"(}, null])"s, "a null request must be rejected"s);
+
+        CheckRejected<std::out_of_range>(R"([{"name": "A"}])"s, "type is required"s);
+        CheckRejected<std::out_of_range>(R"([{"type": "Stop", "latitude": 55.0, "longitude": 37.0, "road_distances": {}}])"s, "name is required"s);
+        CheckRejected<std::out_of_range>(R"([{"type": "Stop", "name": "A", "longitude": 37.0, "road_distances": {}}])"s, "latitude is required"s);
+        CheckRejected<std::out_of_range>(R"([{"type": "Stop", "name": "A", "latitude": 55.0, "road_distances": {}}])"s, "longitude is required"s);
+        CheckRejected<std::out_of_range>(R"([{"type": "Stop", "name": "A", "latitude": 55.0, "longitude": 37.0}])"s, "road_distances is required"s);
+        CheckRejected<std::out_of_range>(R"([{)"s + stop + R"(}, {"type": "Bus", "name": "1", "is_roundtrip": true}])"s, "stops is required"s);
+        CheckRejected<std::out_of_range>(R"([{)"s + stop + R"(}, {"type": "Bus", "name": "1", "stops": ["A"]}])"s, "is_roundtrip is required"s);
+
+        CheckRejected<std::logic_error>(R"([{"type": 1, "name": "A"}])"s, "type must be a string"s);
+        CheckRejected<std::logic_error>(R"([{"type": "Stop", "name": ["A"], "latitude": 55.0, "longitude": 37.0, "road_distances": {}}])"s, "name must be a string"s);
+        CheckRejected<std::logic_error>(R"([{"type": "Stop", "name": "A", "latitude": "55", "longitude": 37.0, "road_distances": {}}])"s, "latitude must be a number"s);
+        CheckRejected<std::logic_error>(R"([{"type": "Stop", "name": "A", "latitude": 55.0, "longitude": true, "road_distances": {}}])"s, "longitude must be a number"s);
+        CheckRejected<std::logic_error>(R"([{)"s + stop + R"(}, {"type": "Bus", "name": "1", "stops": "A", "is_roundtrip": true}])"s, "stops must be an array"s);
+        CheckRejected<std::logic_error>(R"([{)"s + stop + R"(}, {"type": "Bus", "name": "1", "stops": ["A", 7], "is_roundtrip": true}])"s, "stops must contain strings"s);
+        CheckRejected<std::logic_error>(R"([{)"s + stop + R"(}, {"type": "Bus", "name": "1", "stops": ["A"], "is_roundtrip": "yes"}])"s, "is_roundtrip must be a bool"s);
+
+        transport_catalogue::TransportCatalogue catalogue;
+        std::istringstream input(R"({"base_requests": [{)"s + stop + R"(, "extra": [1, {"stops": 2}]}, {)"s + bus + R"(}]})"s);
+        JsonReader reader(input, catalogue);
+        Check(catalogue.FindRoute("1"sv) != nullptr, "unknown fields of any type are ignored"s);
+    }
+
+}  // namespace
+
+int main() {
+    TestCatalogueRejectsUnknownStop();
+    TestReaderSkipsUnknownStop();
+    TestReaderRejectsNonIntDistance();
+    TestReaderRejectsMalformedRequests();
+    if (failures == 0) {
+        std::cout << "OK"sv << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
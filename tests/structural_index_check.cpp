@@ -0,0 +1,147 @@
+// Проверка структурного индекса: скалярная, SSE2 и AVX2 реализации должны
+// давать одни и те же позиции лексем, совпадающие с посимвольным разбором.
+// Уровни, которых нет у процессора, проверяются только до доступного
+#include "json_structural_index.h"
+
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+    int failures = 0;
+
+    void Check(bool condition, const std::string& message) {
+        if (!condition) {
+            std::cerr << "FAILED: "sv << message << std::endl;
+            ++failures;
+        }
+    }
+
+    bool IsOp(char c) {
+        return c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',';
+    }
+
+    bool IsWhitespace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+    }
+
+    // Лексемы вне строк, найденные посимвольно: структурные символы,
+    // открывающие кавычки и первые символы чисел и литералов. Обратный слеш
+    // экранирует следующий символ и внутри, и вне строк
+    std::vector<uint32_t> FindTokens(const std::string& input) {
+        std::vector<uint32_t> tokens;
+        bool in_string = false;
+        bool escaped = false;
+        bool prev_scalar = false;
+        for (size_t i = 0; i < input.size(); ++i) {
+            const char c = input[i];
+            const bool is_escaped = escaped;
+            escaped = c == '\\' && !is_escaped;
+            if (in_string) {
+                if (c == '"' && !is_escaped) {
+                    in_string = false;
+                }
+                continue;
+            }
+            if (c == '"' && !is_escaped) {
+                if (!prev_scalar) {
+                    tokens.push_back(static_cast<uint32_t>(i));
+                }
+                in_string = true;
+                prev_scalar = false;
+            }
+            else if (IsOp(c)) {
+                tokens.push_back(static_cast<uint32_t>(i));
+                prev_scalar = false;
+            }
+            else if (IsWhitespace(c)) {
+                prev_scalar = false;
+            }
+            else {
+                if (!prev_scalar) {
+                    tokens.push_back(static_cast<uint32_t>(i));
+                }
+                prev_scalar = true;
+            }
+        }
+        return tokens;
+    }
+
+    void CheckInput(const std::string& input, const std::string& description) {
+        const std::vector<uint32_t> expected = FindTokens(input);
+        for (const auto& [level, name] : { std::pair{ json::SimdLevel::SCALAR, "scalar"s },
+                                           std::pair{ json::SimdLevel::SSE2, "SSE2"s },
+                                           std::pair{ json::SimdLevel::AVX2, "AVX2"s } }) {
+            if (level > json::GetSimdLevel()) {
+                continue;
+            }
+            Check(json::StructuralIndex(input, level).GetPositions() == expected,
+                name + " index differs on "s + description + ": "s + input);
+        }
+    }
+
+    // Случайный текст из символов, на которых расходятся ветви классификации
+    void TestRandomInputs() {
+        static const std::string alphabet = "{}[]:,\"\\ \n\t\v\rab1.e-"s;
+        std::mt19937 generator(5);
+        for (int test = 0; test < 20000; ++test) {
+            std::string input(generator() % 300, ' ');
+            for (char& c : input) {
+                c = alphabet[generator() % alphabet.size()];
+            }
+            CheckInput(input, "random input"s);
+        }
+    }
+
+    // Серии обратных слешей любой длины, начинающиеся в каждой позиции около
+    // границы 64-байтных блоков, внутри и вне строк
+    void TestBackslashRuns() {
+        for (size_t prefix = 0; prefix < 140; ++prefix) {
+            for (size_t run = 1; run <= 70; ++run) {
+                const std::string backslashes(run, '\\');
+                CheckInput(std::string(prefix, 'a') + backslashes + "\"x\": [1, 2]"s,
+                    "a backslash run outside strings"s);
+                CheckInput(std::string(prefix, ' ') + "{\""s + backslashes + "\": \"b\\\"\", \"c\": 3}"s,
+                    "a backslash run inside a string"s);
+            }
+        }
+    }
+
+    // Похожие на настоящие запросы строки с экранированием в случайных местах
+    void TestEscapedStrings() {
+        static const std::string pieces[] = { "\\\\"s, "\\\""s, "\\n"s, "x"s, "\\t"s, " "s };
+        std::mt19937 generator(7);
+        for (int test = 0; test < 2000; ++test) {
+            std::string input = "["s;
+            const int count = 1 + generator() % 20;
+            for (int i = 0; i < count; ++i) {
+                input += "{\"name\": \""s;
+                const int length = generator() % 40;
+                for (int j = 0; j < length; ++j) {
+                    input += pieces[generator() % std::size(pieces)];
+                }
+                input += "\", \"latitude\": 55.75, \"stops\": [\"a\", \"b\"]},"s;
+            }
+            input.back() = ']';
+            CheckInput(input, "escaped strings"s);
+        }
+    }
+
+}  // namespace
+
+int main() {
+    TestRandomInputs();
+    TestBackslashRuns();
+    TestEscapedStrings();
+    if (failures == 0) {
+        std::cout << "OK"sv << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,477 @@
+#pragma once
+
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Иерархии сжатия (Contraction Hierarchies). При построении вершины по очереди
+    // стягиваются, а кратчайшие пути через них сохраняются шорткатами. Запрос -
+    // двунаправленный Дейкстра только по рёбрам, ведущим к вершинам с большим
+    // рангом; найденные шорткаты раскрываются обратно в рёбра исходного графа
+    template <typename Weight>
+    class ContractionHierarchyRouter final : public RouterBase<Weight> {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+        explicit ContractionHierarchyRouter(const Graph& graph);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    private:
+        static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+        // Поиск свидетелей ограничен, чтобы предобработка не вырождалась в
+        // полный Дейкстра; лишний шорткат не нарушает корректность
+        static constexpr size_t WITNESS_SETTLE_LIMIT = 500;
+
+        // Ребро иерархии: либо ребро исходного графа (original), либо шорткат
+        // из двух рёбер иерархии first и second
+        struct HierarchyEdge {
+            VertexId from;
+            VertexId to;
+            Weight weight;
+            EdgeId original;
+            EdgeId first;
+            EdgeId second;
+        };
+
+        struct Arc {
+            VertexId to;
+            Weight weight;
+            EdgeId edge;
+        };
+
+        struct Shortcut {
+            VertexId from;
+            VertexId to;
+            Weight weight;
+            EdgeId first;
+            EdgeId second;
+        };
+
+        // Граф, из которого в процессе предобработки удаляются стянутые вершины
+        struct WorkingGraph {
+            explicit WorkingGraph(size_t vertex_count)
+                : out_arcs(vertex_count)
+                , in_arcs(vertex_count)
+                , contracted(vertex_count, false)
+                , contracted_neighbours(vertex_count, 0) {
+            }
+
+            std::vector<std::vector<Arc>> out_arcs;
+            std::vector<std::vector<Arc>> in_arcs;
+            std::vector<bool> contracted;
+            std::vector<int> contracted_neighbours;
+        };
+
+        // Рабочие буферы одного направления поиска; вершина достигнута,
+        // только если её метка равна epoch
+        struct SearchSide {
+            explicit SearchSide(size_t vertex_count)
+                : weights(vertex_count)
+                , prev_edges(vertex_count, NO_EDGE)
+                , marks(vertex_count, 0) {
+            }
+
+            void Reset() {
+                if (++epoch == 0) {
+                    std::fill(marks.begin(), marks.end(), 0);
+                    epoch = 1;
+                }
+                queue.clear();
+            }
+
+            bool IsReached(VertexId vertex) const {
+                return marks[vertex] == epoch;
+            }
+
+            void Reach(VertexId vertex, Weight weight, EdgeId prev_edge) {
+                marks[vertex] = epoch;
+                weights[vertex] = weight;
+                prev_edges[vertex] = prev_edge;
+                queue.emplace_back(weight, vertex);
+                std::push_heap(queue.begin(), queue.end(), std::greater<std::pair<Weight, VertexId>>{});
+            }
+
+            std::pair<Weight, VertexId> Pop() {
+                std::pop_heap(queue.begin(), queue.end(), std::greater<std::pair<Weight, VertexId>>{});
+                const auto top = queue.back();
+                queue.pop_back();
+                return top;
+            }
+
+            std::vector<Weight> weights;
+            std::vector<EdgeId> prev_edges;
+            std::vector<uint32_t> marks;
+            std::vector<std::pair<Weight, VertexId>> queue;
+            uint32_t epoch = 0;
+        };
+
+        struct SearchState {
+            explicit SearchState(size_t vertex_count)
+                : forward(vertex_count)
+                , backward(vertex_count) {
+            }
+
+            SearchSide forward;
+            SearchSide backward;
+        };
+
+        void InitializeWorkingGraph(const Graph& graph, WorkingGraph& working_graph);
+        void ContractVertices(WorkingGraph& working_graph, std::vector<size_t>& ranks);
+        std::vector<Shortcut> FindShortcuts(const WorkingGraph& working_graph, VertexId vertex, SearchSide& witness) const;
+        void AddShortcut(WorkingGraph& working_graph, const Shortcut& shortcut);
+        void BuildSearchGraphs(const std::vector<size_t>& ranks);
+
+        void UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const;
+
+        static constexpr Weight ZERO_WEIGHT{};
+        size_t vertex_count_;
+        std::vector<HierarchyEdge> edges_;
+
+        // Рёбра вверх по рангу: up - для прямого поиска от from,
+        // down - развёрнутые рёбра для обратного поиска от to
+        std::vector<size_t> up_offsets_;
+        std::vector<Arc> up_arcs_;
+        std::vector<size_t> down_offsets_;
+        std::vector<Arc> down_arcs_;
+
+        SearchStatePool<SearchState> states_;
+    };
+
+    template <typename Weight>
+    ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph)
+        : vertex_count_(graph.GetVertexCount())
+        , states_(graph.GetVertexCount())
+    {
+        WorkingGraph working_graph(vertex_count_);
+        InitializeWorkingGraph(graph, working_graph);
+
+        std::vector<size_t> ranks(vertex_count_, 0);
+        ContractVertices(working_graph, ranks);
+        BuildSearchGraphs(ranks);
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::InitializeWorkingGraph(const Graph& graph, WorkingGraph& working_graph) {
+        // Из параллельных рёбер в иерархию попадает только самое лёгкое
+        std::vector<EdgeId> edge_ids;
+        edge_ids.reserve(graph.GetEdgeCount());
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            if (edge.from != edge.to) {
+                edge_ids.push_back(edge_id);
+            }
+        }
+        std::stable_sort(edge_ids.begin(), edge_ids.end(), [&graph](EdgeId lhs, EdgeId rhs) {
+            const auto& lhs_edge = graph.GetEdge(lhs);
+            const auto& rhs_edge = graph.GetEdge(rhs);
+            return std::tie(lhs_edge.from, lhs_edge.to, lhs_edge.weight) < std::tie(rhs_edge.from, rhs_edge.to, rhs_edge.weight);
+        });
+
+        for (size_t i = 0; i < edge_ids.size(); ++i) {
+            const auto& edge = graph.GetEdge(edge_ids[i]);
+            if (i > 0) {
+                const auto& prev_edge = graph.GetEdge(edge_ids[i - 1]);
+                if (prev_edge.from == edge.from && prev_edge.to == edge.to) {
+                    continue;
+                }
+            }
+            const EdgeId hierarchy_edge = edges_.size();
+            edges_.push_back({ edge.from, edge.to, edge.weight, edge_ids[i], NO_EDGE, NO_EDGE });
+            working_graph.out_arcs[edge.from].push_back({ edge.to, edge.weight, hierarchy_edge });
+            working_graph.in_arcs[edge.to].push_back({ edge.from, edge.weight, hierarchy_edge });
+        }
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::ContractVertices(WorkingGraph& working_graph, std::vector<size_t>& ranks) {
+        SearchSide witness(vertex_count_);
+
+        const auto priority = [&working_graph](VertexId vertex, size_t shortcut_count) {
+            const int degree = static_cast<int>(working_graph.out_arcs[vertex].size() + working_graph.in_arcs[vertex].size());
+            return static_cast<int>(shortcut_count) - degree + working_graph.contracted_neighbours[vertex];
+        };
+
+        using QueueItem = std::pair<int, VertexId>;
+        std::vector<QueueItem> queue;
+        queue.reserve(vertex_count_);
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            queue.emplace_back(priority(vertex, FindShortcuts(working_graph, vertex, witness).size()), vertex);
+        }
+        std::make_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+
+        // Ленивое обновление: приоритет извлечённой вершины пересчитывается, и если
+        // она перестала быть минимальной, то возвращается в очередь
+        size_t next_rank = 0;
+        while (!queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+            const VertexId vertex = queue.back().second;
+            queue.pop_back();
+
+            std::vector<Shortcut> shortcuts = FindShortcuts(working_graph, vertex, witness);
+            const int vertex_priority = priority(vertex, shortcuts.size());
+            if (!queue.empty() && vertex_priority > queue.front().first) {
+                queue.emplace_back(vertex_priority, vertex);
+                std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+                continue;
+            }
+
+            for (const Shortcut& shortcut : shortcuts) {
+                AddShortcut(working_graph, shortcut);
+            }
+
+            working_graph.contracted[vertex] = true;
+            ranks[vertex] = next_rank++;
+
+            const auto is_contracted_arc = [&working_graph](const Arc& arc) {
+                return working_graph.contracted[arc.to];
+            };
+            for (const Arc& arc : working_graph.out_arcs[vertex]) {
+                auto& arcs = working_graph.in_arcs[arc.to];
+                arcs.erase(std::remove_if(arcs.begin(), arcs.end(), is_contracted_arc), arcs.end());
+                ++working_graph.contracted_neighbours[arc.to];
+            }
+            for (const Arc& arc : working_graph.in_arcs[vertex]) {
+                auto& arcs = working_graph.out_arcs[arc.to];
+                arcs.erase(std::remove_if(arcs.begin(), arcs.end(), is_contracted_arc), arcs.end());
+                ++working_graph.contracted_neighbours[arc.to];
+            }
+            working_graph.out_arcs[vertex].clear();
+            working_graph.out_arcs[vertex].shrink_to_fit();
+            working_graph.in_arcs[vertex].clear();
+            working_graph.in_arcs[vertex].shrink_to_fit();
+        }
+    }
+
+    template <typename Weight>
+    std::vector<typename ContractionHierarchyRouter<Weight>::Shortcut> ContractionHierarchyRouter<Weight>::FindShortcuts(
+        const WorkingGraph& working_graph, VertexId vertex, SearchSide& witness) const {
+        std::vector<Shortcut> shortcuts;
+        const auto& out_arcs = working_graph.out_arcs[vertex];
+        if (out_arcs.empty()) {
+            return shortcuts;
+        }
+
+        for (const Arc& in_arc : working_graph.in_arcs[vertex]) {
+            const VertexId source = in_arc.to;
+
+            Weight max_out_weight = ZERO_WEIGHT;
+            for (const Arc& out_arc : out_arcs) {
+                if (out_arc.to != source) {
+                    max_out_weight = std::max(max_out_weight, out_arc.weight);
+                }
+            }
+            const Weight max_weight = in_arc.weight + max_out_weight;
+
+            // Ищем пути из source в обход vertex не длиннее max_weight
+            witness.Reset();
+            witness.Reach(source, ZERO_WEIGHT, NO_EDGE);
+            size_t settled = 0;
+            while (!witness.queue.empty() && settled < WITNESS_SETTLE_LIMIT) {
+                const auto [weight, current] = witness.Pop();
+                if (witness.weights[current] < weight) {
+                    continue;
+                }
+                if (max_weight < weight) {
+                    break;
+                }
+                ++settled;
+                for (const Arc& arc : working_graph.out_arcs[current]) {
+                    if (arc.to == vertex) {
+                        continue;
+                    }
+                    const Weight candidate_weight = weight + arc.weight;
+                    if (!witness.IsReached(arc.to) || candidate_weight < witness.weights[arc.to]) {
+                        witness.Reach(arc.to, candidate_weight, arc.edge);
+                    }
+                }
+            }
+
+            for (const Arc& out_arc : out_arcs) {
+                const VertexId target = out_arc.to;
+                if (target == source) {
+                    continue;
+                }
+                const Weight via_weight = in_arc.weight + out_arc.weight;
+                if (witness.IsReached(target) && !(via_weight < witness.weights[target])) {
+                    continue;
+                }
+                shortcuts.push_back({ source, target, via_weight, in_arc.edge, out_arc.edge });
+            }
+        }
+
+        return shortcuts;
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::AddShortcut(WorkingGraph& working_graph, const Shortcut& shortcut) {
+        auto& out_arcs = working_graph.out_arcs[shortcut.from];
+        auto existing = std::find_if(out_arcs.begin(), out_arcs.end(), [&shortcut](const Arc& arc) {
+            return arc.to == shortcut.to;
+        });
+        if (existing != out_arcs.end() && !(shortcut.weight < existing->weight)) {
+            return;
+        }
+
+        const EdgeId hierarchy_edge = edges_.size();
+        edges_.push_back({ shortcut.from, shortcut.to, shortcut.weight, NO_EDGE, shortcut.first, shortcut.second });
+
+        if (existing != out_arcs.end()) {
+            *existing = { shortcut.to, shortcut.weight, hierarchy_edge };
+            for (Arc& arc : working_graph.in_arcs[shortcut.to]) {
+                if (arc.to == shortcut.from) {
+                    arc = { shortcut.from, shortcut.weight, hierarchy_edge };
+                }
+            }
+        }
+        else {
+            out_arcs.push_back({ shortcut.to, shortcut.weight, hierarchy_edge });
+            working_graph.in_arcs[shortcut.to].push_back({ shortcut.from, shortcut.weight, hierarchy_edge });
+        }
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::BuildSearchGraphs(const std::vector<size_t>& ranks) {
+        up_offsets_.assign(vertex_count_ + 1, 0);
+        down_offsets_.assign(vertex_count_ + 1, 0);
+        for (const HierarchyEdge& edge : edges_) {
+            if (ranks[edge.from] < ranks[edge.to]) {
+                ++up_offsets_[edge.from + 1];
+            }
+            else {
+                ++down_offsets_[edge.to + 1];
+            }
+        }
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            up_offsets_[vertex + 1] += up_offsets_[vertex];
+            down_offsets_[vertex + 1] += down_offsets_[vertex];
+        }
+
+        up_arcs_.resize(up_offsets_.back());
+        down_arcs_.resize(down_offsets_.back());
+        std::vector<size_t> up_positions(up_offsets_.begin(), up_offsets_.end() - 1);
+        std::vector<size_t> down_positions(down_offsets_.begin(), down_offsets_.end() - 1);
+        for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+            const HierarchyEdge& edge = edges_[edge_id];
+            if (ranks[edge.from] < ranks[edge.to]) {
+                up_arcs_[up_positions[edge.from]++] = { edge.to, edge.weight, edge_id };
+            }
+            else {
+                down_arcs_[down_positions[edge.to]++] = { edge.from, edge.weight, edge_id };
+            }
+        }
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const {
+        std::vector<EdgeId> stack{ edge_id };
+        while (!stack.empty()) {
+            const HierarchyEdge& edge = edges_[stack.back()];
+            stack.pop_back();
+            if (edge.original != NO_EDGE) {
+                edges.push_back(edge.original);
+            }
+            else {
+                stack.push_back(edge.second);
+                stack.push_back(edge.first);
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo> ContractionHierarchyRouter<Weight>::BuildRoute(
+        VertexId from, VertexId to) const {
+        if (from >= vertex_count_ || to >= vertex_count_) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+
+        auto state = states_.Acquire();
+        SearchSide& forward = state->forward;
+        SearchSide& backward = state->backward;
+        forward.Reset();
+        backward.Reset();
+        forward.Reach(from, ZERO_WEIGHT, NO_EDGE);
+        backward.Reach(to, ZERO_WEIGHT, NO_EDGE);
+
+        std::optional<Weight> best_weight;
+        VertexId meeting_vertex = from;
+
+        // Направление прекращает поиск, когда его минимальный ключ не меньше
+        // лучшего найденного пути
+        const auto step = [&best_weight, &meeting_vertex](SearchSide& side, const SearchSide& other_side,
+            const std::vector<size_t>& offsets, const std::vector<Arc>& arcs) {
+            const auto [weight, vertex] = side.Pop();
+            if (side.weights[vertex] < weight) {
+                return;
+            }
+            if (best_weight && !(weight < *best_weight)) {
+                side.queue.clear();
+                return;
+            }
+            if (other_side.IsReached(vertex)) {
+                const Weight total_weight = weight + other_side.weights[vertex];
+                if (!best_weight || total_weight < *best_weight) {
+                    best_weight = total_weight;
+                    meeting_vertex = vertex;
+                }
+            }
+            for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+                const Arc& arc = arcs[i];
+                const Weight candidate_weight = weight + arc.weight;
+                if (!side.IsReached(arc.to) || candidate_weight < side.weights[arc.to]) {
+                    side.Reach(arc.to, candidate_weight, arc.edge);
+                }
+            }
+        };
+
+        while (!forward.queue.empty() || !backward.queue.empty()) {
+            if (!forward.queue.empty()) {
+                step(forward, backward, up_offsets_, up_arcs_);
+            }
+            if (!backward.queue.empty()) {
+                step(backward, forward, down_offsets_, down_arcs_);
+            }
+        }
+
+        if (!best_weight) {
+            return std::nullopt;
+        }
+
+        std::vector<EdgeId> hierarchy_path;
+        for (VertexId vertex = meeting_vertex; forward.prev_edges[vertex] != NO_EDGE;) {
+            const EdgeId edge_id = forward.prev_edges[vertex];
+            hierarchy_path.push_back(edge_id);
+            vertex = edges_[edge_id].from;
+        }
+        std::reverse(hierarchy_path.begin(), hierarchy_path.end());
+        for (VertexId vertex = meeting_vertex; backward.prev_edges[vertex] != NO_EDGE;) {
+            const EdgeId edge_id = backward.prev_edges[vertex];
+            hierarchy_path.push_back(edge_id);
+            vertex = edges_[edge_id].to;
+        }
+
+        std::vector<EdgeId> edges;
+        for (const EdgeId edge_id : hierarchy_path) {
+            UnpackEdge(edge_id, edges);
+        }
+
+        return RouteInfo{ *best_weight, std::move(edges) };
+    }
+
+}  // namespace graph
\ No newline at end of file
@@ -0,0 +1,260 @@
+#pragma once
+
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Поиск маршрута алгоритмом Дейкстры по запросу: построение за O(E), память
+    // пропорциональна числу рёбер, каждый запрос - O(E log V). Граф должен быть
+    // заморожен (Freeze), чтобы поиск шёл по упакованным массивам.
+    // При ненулевом tree_cache_budget (в байтах) деревья кратчайших путей от
+    // последних использованных исходных вершин сохраняются в LRU-кэше, и
+    // повторный запрос из той же вершины сводится к восстановлению пути
+    template <typename Weight>
+    class DijkstraRouter final : public RouterBase<Weight> {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+        explicit DijkstraRouter(const Graph& graph, size_t tree_cache_budget = 0);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    private:
+        static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+        // Дерево кратчайших путей из одной вершины; недостижимые вершины
+        // (кроме самого источника) имеют prev_edge == NO_EDGE
+        struct ShortestPathTree {
+            VertexId source;
+            std::vector<Weight> weights;
+            std::vector<EdgeId> prev_edges;
+        };
+        using TreePtr = std::shared_ptr<const ShortestPathTree>;
+        using LruList = std::list<TreePtr>;
+
+        // Рабочие буферы одного поиска. Чтобы не очищать их за O(V) перед каждым
+        // запросом, вершина считается достигнутой, только если её метка равна epoch
+        struct SearchState {
+            explicit SearchState(size_t vertex_count)
+                : weights(vertex_count)
+                , prev_edges(vertex_count, NO_EDGE)
+                , marks(vertex_count, 0) {
+            }
+
+            void Reset() {
+                if (++epoch == 0) {
+                    std::fill(marks.begin(), marks.end(), 0);
+                    epoch = 1;
+                }
+                queue.clear();
+            }
+
+            bool IsReached(VertexId vertex) const {
+                return marks[vertex] == epoch;
+            }
+
+            std::vector<Weight> weights;
+            std::vector<EdgeId> prev_edges;
+            std::vector<uint32_t> marks;
+            std::vector<std::pair<Weight, VertexId>> queue;
+            uint32_t epoch = 0;
+        };
+
+        // Заполняет state кратчайшими путями из from; если to задана,
+        // поиск останавливается, как только она извлечена из очереди
+        void RunSearch(SearchState& state, VertexId from, std::optional<VertexId> to) const;
+
+        TreePtr FindCachedTree(VertexId from) const;
+        TreePtr BuildTree(VertexId from) const;
+        void CacheTree(TreePtr tree) const;
+
+        std::optional<RouteInfo> BuildRouteFromTree(const ShortestPathTree& tree, VertexId to) const;
+
+        static constexpr Weight ZERO_WEIGHT{};
+        const Graph& graph_;
+
+        SearchStatePool<SearchState> states_;
+
+        // Вмещается не более max_cached_trees_ деревьев; список упорядочен
+        // от недавно использованных к давно использованным
+        size_t max_cached_trees_ = 0;
+        mutable std::mutex cache_mutex_;
+        mutable LruList lru_trees_;
+        mutable std::unordered_map<VertexId, typename LruList::iterator> cached_trees_;
+    };
+
+    template <typename Weight>
+    DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph, size_t tree_cache_budget)
+        : graph_(graph)
+        , states_(graph.GetVertexCount())
+    {
+        if (!graph.IsFrozen()) {
+            throw std::logic_error("Graph should be frozen before building a router");
+        }
+
+        const size_t edge_count = graph.GetEdgeCount();
+        for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+            if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+
+        const size_t tree_size = sizeof(ShortestPathTree)
+            + graph.GetVertexCount() * (sizeof(Weight) + sizeof(EdgeId));
+        max_cached_trees_ = tree_cache_budget / tree_size;
+    }
+
+    template <typename Weight>
+    void DijkstraRouter<Weight>::RunSearch(SearchState& state, VertexId from, std::optional<VertexId> to) const {
+        state.Reset();
+
+        // Очередь с ленивым удалением: устаревшие записи пропускаются при извлечении
+        const auto queue_order = std::greater<std::pair<Weight, VertexId>>{};
+        state.marks[from] = state.epoch;
+        state.weights[from] = ZERO_WEIGHT;
+        state.prev_edges[from] = NO_EDGE;
+        state.queue.emplace_back(ZERO_WEIGHT, from);
+
+        while (!state.queue.empty()) {
+            std::pop_heap(state.queue.begin(), state.queue.end(), queue_order);
+            const auto [weight, vertex] = state.queue.back();
+            state.queue.pop_back();
+
+            if (state.weights[vertex] < weight) {
+                continue;
+            }
+            if (vertex == to) {
+                break;
+            }
+
+            const OutgoingArcs<Weight> arcs = graph_.GetOutgoingArcs(vertex);
+            for (size_t i = 0; i < arcs.size; ++i) {
+                const VertexId target = arcs.targets[i];
+                const Weight candidate_weight = weight + arcs.weights[i];
+                if (!state.IsReached(target) || candidate_weight < state.weights[target]) {
+                    state.marks[target] = state.epoch;
+                    state.weights[target] = candidate_weight;
+                    state.prev_edges[target] = arcs.edge_ids[i];
+                    state.queue.emplace_back(candidate_weight, target);
+                    std::push_heap(state.queue.begin(), state.queue.end(), queue_order);
+                }
+            }
+        }
+    }
+
+    template <typename Weight>
+    typename DijkstraRouter<Weight>::TreePtr DijkstraRouter<Weight>::FindCachedTree(VertexId from) const {
+        std::lock_guard guard(cache_mutex_);
+        auto it = cached_trees_.find(from);
+        if (it == cached_trees_.end()) {
+            return nullptr;
+        }
+        lru_trees_.splice(lru_trees_.begin(), lru_trees_, it->second);
+        return *it->second;
+    }
+
+    template <typename Weight>
+    typename DijkstraRouter<Weight>::TreePtr DijkstraRouter<Weight>::BuildTree(VertexId from) const {
+        auto state = states_.Acquire();
+        RunSearch(*state, from, std::nullopt);
+
+        const size_t vertex_count = graph_.GetVertexCount();
+        auto tree = std::make_shared<ShortestPathTree>();
+        tree->source = from;
+        tree->weights.resize(vertex_count, ZERO_WEIGHT);
+        tree->prev_edges.resize(vertex_count, NO_EDGE);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            if (state->IsReached(vertex)) {
+                tree->weights[vertex] = state->weights[vertex];
+                tree->prev_edges[vertex] = state->prev_edges[vertex];
+            }
+        }
+        return tree;
+    }
+
+    template <typename Weight>
+    void DijkstraRouter<Weight>::CacheTree(TreePtr tree) const {
+        std::lock_guard guard(cache_mutex_);
+        const VertexId source = tree->source;
+        if (cached_trees_.count(source)) {
+            // Дерево успел построить параллельный запрос
+            return;
+        }
+        lru_trees_.push_front(std::move(tree));
+        cached_trees_[source] = lru_trees_.begin();
+        while (lru_trees_.size() > max_cached_trees_) {
+            cached_trees_.erase(lru_trees_.back()->source);
+            lru_trees_.pop_back();
+        }
+    }
+
+    template <typename Weight>
+    std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRouteFromTree(
+        const ShortestPathTree& tree, VertexId to) const {
+        if (to != tree.source && tree.prev_edges[to] == NO_EDGE) {
+            return std::nullopt;
+        }
+
+        std::vector<EdgeId> edges;
+        for (EdgeId edge_id = tree.prev_edges[to]; edge_id != NO_EDGE;
+            edge_id = tree.prev_edges[graph_.GetEdge(edge_id).from])
+        {
+            edges.push_back(edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return RouteInfo{ tree.weights[to], std::move(edges) };
+    }
+
+    template <typename Weight>
+    std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+        VertexId to) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+
+        if (max_cached_trees_ > 0) {
+            TreePtr tree = FindCachedTree(from);
+            if (!tree) {
+                tree = BuildTree(from);
+                CacheTree(tree);
+            }
+            return BuildRouteFromTree(*tree, to);
+        }
+
+        auto state = states_.Acquire();
+        RunSearch(*state, from, to);
+
+        if (!state->IsReached(to)) {
+            return std::nullopt;
+        }
+
+        std::vector<EdgeId> edges;
+        for (EdgeId edge_id = state->prev_edges[to]; edge_id != NO_EDGE;
+            edge_id = state->prev_edges[graph_.GetEdge(edge_id).from])
+        {
+            edges.push_back(edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return RouteInfo{ state->weights[to], std::move(edges) };
+    }
+
+}  // namespace graph
\ No newline at end of file
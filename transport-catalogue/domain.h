@@ -2,23 +2,25 @@
 
 #include "geo.h"
 
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <set>
 #include <unordered_map>
 
 namespace transport_catalogue {
 
+    // Плотные идентификаторы в порядке добавления в справочник
+    using StopId = uint32_t;
+    using BusId = uint32_t;
+
     struct Stop {
-        std::string name;
+        StopId id;
+        // Имена хранятся в StringPool справочника
+        std::string_view name;
         geo::Coordinates coordinates;
-        std::set<std::string> buses_by_stop;
-    };
-
-    struct Bus {
-        std::string number;
-        std::vector<const Stop*> stops;
-        bool is_circle;
     };
 
     struct BusStat {
@@ -28,4 +30,23 @@ namespace transport_catalogue {
         double curvature;
     };
 
+    struct Bus {
+        BusId id;
+        std::string_view number;
+        std::vector<const Stop*> stops;
+        bool is_circle;
+        // Префиксные суммы дорожных расстояний: forward_distances[i] - путь от stops[0]
+        // до stops[i], backward_distances[i] - путь от stops[i] обратно до stops[0]
+        std::vector<int> forward_distances;
+        std::vector<int> backward_distances;
+        // Статистика маршрута; сбрасывается при изменении расстояний на нём
+        std::optional<BusStat> stat;
+    };
+
+    struct StopDistance {
+        const Stop* from;
+        const Stop* to;
+        int distance;
+    };
+
 } // namespace transport_catalogue
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "ranges.h"
 
 #include <cstdlib>
+#include <stdexcept>
 #include <vector>
 
 namespace graph {
@@ -12,50 +13,108 @@ namespace graph {
 
     template <typename Weight>
     struct Edge {
-        std::string name;
-        size_t quality;
         VertexId from;
         VertexId to;
         Weight weight;
     };
 
+    // Исходящие из вершины рёбра в упакованном (CSR) виде: i-е ребро ведёт
+    // в targets[i], имеет вес weights[i] и идентификатор edge_ids[i]
+    template <typename Weight>
+    struct OutgoingArcs {
+        const VertexId* targets;
+        const Weight* weights;
+        const EdgeId* edge_ids;
+        size_t size;
+    };
+
     template <typename Weight>
     class DirectedWeightedGraph {
     private:
         using IncidenceList = std::vector<EdgeId>;
-        using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+        using IncidentEdgesRange = ranges::Range<const EdgeId*>;
 
     public:
         DirectedWeightedGraph() = default;
         explicit DirectedWeightedGraph(size_t vertex_count);
         EdgeId AddEdge(const Edge<Weight>& edge);
 
+        // Переводит граф в неизменяемый CSR-вид: смещения, цели и веса рёбер лежат
+        // в непрерывных массивах, списки смежности освобождаются. После вызова
+        // добавлять рёбра нельзя
+        void Freeze();
+        bool IsFrozen() const;
+
         size_t GetVertexCount() const;
         size_t GetEdgeCount() const;
         const Edge<Weight>& GetEdge(EdgeId edge_id) const;
         IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+        OutgoingArcs<Weight> GetOutgoingArcs(VertexId vertex) const;
 
     private:
+        size_t vertex_count_ = 0;
         std::vector<Edge<Weight>> edges_;
         std::vector<IncidenceList> incidence_lists_;
+
+        bool frozen_ = false;
+        std::vector<size_t> offsets_;
+        std::vector<VertexId> targets_;
+        std::vector<Weight> weights_;
+        std::vector<EdgeId> edge_ids_;
     };
 
     template <typename Weight>
     DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-        : incidence_lists_(vertex_count) {
+        : vertex_count_(vertex_count)
+        , incidence_lists_(vertex_count) {
     }
 
     template <typename Weight>
     EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+        if (frozen_) {
+            throw std::logic_error("Could not add an edge to a frozen graph");
+        }
         edges_.push_back(edge);
         const EdgeId id = edges_.size() - 1;
         incidence_lists_.at(edge.from).push_back(id);
         return id;
     }
 
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::Freeze() {
+        if (frozen_) {
+            return;
+        }
+
+        offsets_.assign(vertex_count_ + 1, 0);
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            offsets_[vertex + 1] = offsets_[vertex] + incidence_lists_[vertex].size();
+        }
+
+        targets_.reserve(edges_.size());
+        weights_.reserve(edges_.size());
+        edge_ids_.reserve(edges_.size());
+        for (const IncidenceList& incidence_list : incidence_lists_) {
+            for (const EdgeId edge_id : incidence_list) {
+                targets_.push_back(edges_[edge_id].to);
+                weights_.push_back(edges_[edge_id].weight);
+                edge_ids_.push_back(edge_id);
+            }
+        }
+
+        incidence_lists_.clear();
+        incidence_lists_.shrink_to_fit();
+        frozen_ = true;
+    }
+
+    template <typename Weight>
+    bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+        return frozen_;
+    }
+
     template <typename Weight>
     size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-        return incidence_lists_.size();
+        return vertex_count_;
     }
 
     template <typename Weight>
@@ -71,7 +130,22 @@ namespace graph {
     template <typename Weight>
     typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
         DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-        return ranges::AsRange(incidence_lists_.at(vertex));
+        if (frozen_) {
+            const EdgeId* begin = edge_ids_.data() + offsets_.at(vertex);
+            return { begin, begin + (offsets_[vertex + 1] - offsets_[vertex]) };
+        }
+        const IncidenceList& incidence_list = incidence_lists_.at(vertex);
+        return { incidence_list.data(), incidence_list.data() + incidence_list.size() };
+    }
+
+    template <typename Weight>
+    OutgoingArcs<Weight> DirectedWeightedGraph<Weight>::GetOutgoingArcs(VertexId vertex) const {
+        if (!frozen_) {
+            throw std::logic_error("Graph should be frozen to get packed arcs");
+        }
+        const size_t offset = offsets_[vertex];
+        return { targets_.data() + offset, weights_.data() + offset, edge_ids_.data() + offset,
+                 offsets_[vertex + 1] - offset };
     }
 
 } // namespace graph
\ No newline at end of file
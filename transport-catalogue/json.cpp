@@ -1,5 +1,8 @@
 #include "json.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <iterator>
 
 namespace json {
@@ -7,305 +10,386 @@ namespace json {
     namespace {
         using namespace std::literals;
 
-        Node LoadNode(std::istream& input);
-        Node LoadString(std::istream& input);
+        // На коротких входах построение структурного индекса не окупается
+        constexpr size_t INDEX_MIN_INPUT_SIZE = 4096;
 
-        std::string LoadLiteral(std::istream& input) {
-            std::string s;
-            while (std::isalpha(input.peek())) {
-                s.push_back(static_cast<char>(input.get()));
-            }
-            return s;
+        bool IsSpace(char c) {
+            return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
         }
 
-        Node LoadArray(std::istream& input) {
-            std::vector<Node> result;
+        // Разбор документа, целиком лежащего в непрерывном буфере: курсор
+        // движется по указателю, а о каждом прочитанном элементе сообщается handler
+        class Parser {
+        public:
+            Parser(const char* begin, const char* end, Handler& handler)
+                : pos_(begin)
+                , end_(end)
+                , handler_(handler) {
+            }
 
-            for (char c; input >> c && c != ']';) {
-                if (c != ',') {
-                    input.putback(c);
+            void ParseNode() {
+                SkipWhitespace();
+                if (pos_ == end_) {
+                    throw ParsingError("Unexpected EOF"s);
+                }
+                switch (*pos_) {
+                case '[':
+                    ++pos_;
+                    ParseArray();
+                    break;
+                case '{':
+                    ++pos_;
+                    ParseDict();
+                    break;
+                case '"':
+                    ++pos_;
+                    handler_.String(ParseString());
+                    break;
+                case 't':
+                    // Встретив t или f, переходим к попытке парсинга литералов true либо false
+                    [[fallthrough]];
+                case 'f':
+                    ParseBool();
+                    break;
+                case 'n':
+                    ParseNull();
+                    break;
+                default:
+                    ParseNumber();
+                    break;
                 }
-                result.push_back(LoadNode(input));
             }
-            if (!input) {
-                throw ParsingError("Array parsing error"s);
+
+            // После прочитанного значения остались только пробельные символы
+            bool IsConsumed() {
+                SkipWhitespace();
+                return pos_ == end_;
             }
-            return Node(std::move(result));
-        }
 
-        Node LoadDict(std::istream& input) {
-            Dict dict;
+        private:
+            static bool IsDigit(char c) {
+                return c >= '0' && c <= '9';
+            }
 
-            for (char c; input >> c && c != '}';) {
-                if (c == '"') {
-                    std::string key = LoadString(input).AsString();
-                    if (input >> c && c == ':') {
-                        if (dict.find(key) != dict.end()) {
-                            throw ParsingError("Duplicate key '"s + key + "' have been found");
-                        }
-                        dict.emplace(std::move(key), LoadNode(input));
+            static bool IsAlpha(char c) {
+                return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+            }
+
+            void SkipWhitespace() {
+                while (pos_ != end_ && IsSpace(*pos_)) {
+                    ++pos_;
+                }
+            }
+
+            // Аналог input >> c: пропускает пробельные символы и читает следующий
+            bool ReadChar(char& c) {
+                SkipWhitespace();
+                if (pos_ == end_) {
+                    return false;
+                }
+                c = *pos_++;
+                return true;
+            }
+
+            std::string_view ParseLiteral() {
+                const char* begin = pos_;
+                while (pos_ != end_ && IsAlpha(*pos_)) {
+                    ++pos_;
+                }
+                return { begin, static_cast<size_t>(pos_ - begin) };
+            }
+
+            void ParseArray() {
+                handler_.StartArray();
+
+                char c;
+                bool closed = false;
+                while (ReadChar(c)) {
+                    if (c == ']') {
+                        closed = true;
+                        break;
                     }
-                    else {
-                        throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                    if (c != ',') {
+                        --pos_;
                     }
+                    ParseNode();
                 }
-                else if (c != ',') {
-                    throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+                if (!closed) {
+                    throw ParsingError("Array parsing error"s);
                 }
+                handler_.EndArray();
             }
-            if (!input) {
-                throw ParsingError("Dictionary parsing error"s);
-            }
-            return Node(std::move(dict));
-        }
 
-        Node LoadString(std::istream& input) {
-            auto it = std::istreambuf_iterator<char>(input);
-            auto end = std::istreambuf_iterator<char>();
-            std::string s;
-            while (true) {
-                if (it == end) {
-                    throw ParsingError("String parsing error");
+            void ParseDict() {
+                handler_.StartObject();
+
+                char c;
+                bool closed = false;
+                while (ReadChar(c)) {
+                    if (c == '}') {
+                        closed = true;
+                        break;
+                    }
+                    if (c == '"') {
+                        const std::string_view key = ParseString();
+                        if (ReadChar(c) && c == ':') {
+                            handler_.Key(key);
+                            ParseNode();
+                        }
+                        else {
+                            throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                        }
+                    }
+                    else if (c != ',') {
+                        throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+                    }
                 }
-                const char ch = *it;
-                if (ch == '"') {
-                    ++it;
-                    break;
+                if (!closed) {
+                    throw ParsingError("Dictionary parsing error"s);
                 }
-                else if (ch == '\\') {
-                    ++it;
-                    if (it == end) {
+                handler_.EndObject();
+            }
+
+            // Строка без экранирования возвращается как срез входного буфера;
+            // иначе она собирается в scratch_ и действительна до следующего вызова
+            std::string_view ParseString() {
+                const char* begin = pos_;
+                pos_ = FindStringSpecial(pos_, end_);
+                if (pos_ != end_ && *pos_ == '"') {
+                    return { begin, static_cast<size_t>(pos_++ - begin) };
+                }
+
+                scratch_.assign(begin, pos_);
+                while (true) {
+                    if (pos_ == end_) {
                         throw ParsingError("String parsing error");
                     }
-                    const char escaped_char = *(it);
+
+                    const char ch = *pos_++;
+                    if (ch == '"') {
+                        break;
+                    }
+                    if (ch == '\n' || ch == '\r') {
+                        throw ParsingError("Unexpected end of line"s);
+                    }
+                    if (ch != '\\') {
+                        scratch_.push_back(ch);
+                        continue;
+                    }
+                    if (pos_ == end_) {
+                        throw ParsingError("String parsing error");
+                    }
+                    const char escaped_char = *pos_++;
                     switch (escaped_char) {
                     case 'n':
-                        s.push_back('\n');
+                        scratch_.push_back('\n');
                         break;
                     case 't':
-                        s.push_back('\t');
+                        scratch_.push_back('\t');
                         break;
                     case 'r':
-                        s.push_back('\r');
+                        scratch_.push_back('\r');
                         break;
                     case '"':
-                        s.push_back('"');
+                        scratch_.push_back('"');
                         break;
                     case '\\':
-                        s.push_back('\\');
+                        scratch_.push_back('\\');
                         break;
                     default:
                         throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
                     }
+
+                    // Участок до следующего особого символа копируется целиком
+                    const char* run_begin = pos_;
+                    pos_ = FindStringSpecial(pos_, end_);
+                    scratch_.append(run_begin, pos_);
                 }
-                else if (ch == '\n' || ch == '\r') {
-                    throw ParsingError("Unexpected end of line"s);
+
+                return scratch_;
+            }
+
+            void ParseBool() {
+                const auto s = ParseLiteral();
+                if (s == "true"sv) {
+                    handler_.Bool(true);
+                }
+                else if (s == "false"sv) {
+                    handler_.Bool(false);
                 }
                 else {
-                    s.push_back(ch);
+                    throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
                 }
-                ++it;
             }
 
-            return Node(std::move(s));
-        }
-
-        Node LoadBool(std::istream& input) {
-            const auto s = LoadLiteral(input);
-            if (s == "true"sv) {
-                return Node{ true };
-            }
-            else if (s == "false"sv) {
-                return Node{ false };
-            }
-            else {
-                throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+            void ParseNull() {
+                if (auto literal = ParseLiteral(); literal == "null"sv) {
+                    handler_.Null();
+                }
+                else {
+                    throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
+                }
             }
-        }
 
-        Node LoadNull(std::istream& input) {
-            if (auto literal = LoadLiteral(input); literal == "null"sv) {
-                return Node{ nullptr };
-            }
-            else {
-                throw ParsingError("Failed to parse '"s + literal + "' as null"s);
-            }
-        }
+            void ParseNumber() {
+                const char* begin = pos_;
 
-        Node LoadNumber(std::istream& input) {
-            std::string parsed_num;
+                // Пропускает одну или более цифр
+                auto read_digits = [this] {
+                    if (pos_ == end_ || !IsDigit(*pos_)) {
+                        throw ParsingError("A digit is expected"s);
+                    }
+                    while (pos_ != end_ && IsDigit(*pos_)) {
+                        ++pos_;
+                    }
+                };
 
-            // Считывает в parsed_num очередной символ из input
-            auto read_char = [&parsed_num, &input] {
-                parsed_num += static_cast<char>(input.get());
-                if (!input) {
-                    throw ParsingError("Failed to read number from stream"s);
+                if (pos_ != end_ && *pos_ == '-') {
+                    ++pos_;
+                }
+                // Парсим целую часть числа
+                if (pos_ != end_ && *pos_ == '0') {
+                    ++pos_;
+                    // После 0 в JSON не могут идти другие цифры
+                }
+                else {
+                    read_digits();
                 }
-            };
 
-            // Считывает одну или более цифр в parsed_num из input
-            auto read_digits = [&input, read_char] {
-                if (!std::isdigit(input.peek())) {
-                    throw ParsingError("A digit is expected"s);
+                bool is_int = true;
+                // Парсим дробную часть числа
+                if (pos_ != end_ && *pos_ == '.') {
+                    ++pos_;
+                    read_digits();
+                    is_int = false;
                 }
-                while (std::isdigit(input.peek())) {
-                    read_char();
+
+                // Парсим экспоненциальную часть числа
+                if (pos_ != end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+                    ++pos_;
+                    if (pos_ != end_ && (*pos_ == '+' || *pos_ == '-')) {
+                        ++pos_;
+                    }
+                    read_digits();
+                    is_int = false;
                 }
-            };
 
-            if (input.peek() == '-') {
-                read_char();
-            }
-            // Парсим целую часть числа
-            if (input.peek() == '0') {
-                read_char();
-                // После 0 в JSON не могут идти другие цифры
-            }
-            else {
-                read_digits();
+                if (is_int) {
+                    // Сначала пробуем преобразовать строку в int; при переполнении
+                    // код ниже попробует преобразовать её в double
+                    int value = 0;
+                    if (auto [ptr, ec] = std::from_chars(begin, pos_, value); ec == std::errc{} && ptr == pos_) {
+                        handler_.Int(value);
+                        return;
+                    }
+                }
+                double value = 0.0;
+                if (auto [ptr, ec] = std::from_chars(begin, pos_, value); ec == std::errc{} && ptr == pos_) {
+                    handler_.Double(value);
+                    return;
+                }
+                throw ParsingError("Failed to convert "s + std::string(begin, pos_) + " to number"s);
             }
 
-            bool is_int = true;
-            // Парсим дробную часть числа
-            if (input.peek() == '.') {
-                read_char();
-                read_digits();
-                is_int = false;
-            }
+            const char* pos_;
+            const char* end_;
+            Handler& handler_;
+            std::string scratch_;
+        };
 
-            // Парсим экспоненциальную часть числа
-            if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-                read_char();
-                if (ch = input.peek(); ch == '+' || ch == '-') {
-                    read_char();
-                }
-                read_digits();
-                is_int = false;
+        const char* SkipSpaces(const char* pos, const char* end) {
+            while (pos != end && IsSpace(*pos)) {
+                ++pos;
             }
+            return pos;
+        }
 
-            try {
-                if (is_int) {
-                    // Сначала пробуем преобразовать строку в int
-                    try {
-                        return std::stoi(parsed_num);
-                    }
-                    catch (...) {
-                        // В случае неудачи, например, при переполнении
-                        // код ниже попробует преобразовать строку в double
-                    }
+        // pos указывает на открывающую кавычку; возвращает позицию за
+        // закрывающей либо nullptr, если строка не закрыта
+        const char* SkipString(const char* pos, const char* end) {
+            for (++pos; (pos = FindStringSpecial(pos, end)) != end;) {
+                if (*pos == '"') {
+                    return pos + 1;
                 }
-                return std::stod(parsed_num);
-            }
-            catch (...) {
-                throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
-            }
-        }
-
-        Node LoadNode(std::istream& input) {
-            char c;
-            if (!(input >> c)) {
-                throw ParsingError("Unexpected EOF"s);
-            }
-            switch (c) {
-            case '[':
-                return LoadArray(input);
-            case '{':
-                return LoadDict(input);
-            case '"':
-                return LoadString(input);
-            case 't':
-                // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
-                // подсказкой компилятору и человеку, что здесь программист явно задумывал
-                // разрешить переход к инструкции следующей ветки case, а не случайно забыл
-                // написать break, return или throw.
-                // В данном случае, встретив t или f, переходим к попытке парсинга
-                // литералов true либо false
-                [[fallthrough]];
-            case 'f':
-                input.putback(c);
-                return LoadBool(input);
-            case 'n':
-                input.putback(c);
-                return LoadNull(input);
-            default:
-                input.putback(c);
-                return LoadNumber(input);
+                // За обратным слешем пропускается экранированный символ
+                if (*pos == '\\' && ++pos == end) {
+                    return nullptr;
+                }
+                ++pos;
             }
+            return nullptr;
         }
 
         struct PrintContext {
-            std::ostream& out;
+            std::string& out;
+            PrintMode mode = PrintMode::PRETTY;
             int indent_step = 4;
             int indent = 0;
 
+            bool IsCompact() const {
+                return mode == PrintMode::COMPACT;
+            }
+
             void PrintIndent() const {
-                for (int i = 0; i < indent; ++i) {
-                    out.put(' ');
-                }
+                out.append(static_cast<size_t>(indent), ' ');
             }
 
             PrintContext Indented() const {
-                return { out, indent_step, indent_step + indent };
+                return { out, mode, indent_step, indent_step + indent };
             }
         };
 
         void PrintNode(const Node& value, const PrintContext& ctx);
 
-        template <typename Value>
-        void PrintValue(const Value& value, const PrintContext& ctx) {
-            ctx.out << value;
+        void PrintValue(const std::string& value, const PrintContext& ctx) {
+            PrintString(value, ctx.out);
         }
 
-        void PrintString(const std::string& value, std::ostream& out) {
-            out.put('"');
-            for (const char c : value) {
-                switch (c) {
-                case '\r':
-                    out << "\\r"sv;
-                    break;
-                case '\n':
-                    out << "\\n"sv;
-                    break;
-                case '\t':
-                    out << "\\t"sv;
-                    break;
-                case '"':
-                    // Символы " и \ выводятся как \" или \\, соответственно
-                    [[fallthrough]];
-                case '\\':
-                    out.put('\\');
-                    [[fallthrough]];
-                default:
-                    out.put(c);
-                    break;
-                }
-            }
-            out.put('"');
+        void PrintValue(const RawJson& value, const PrintContext& ctx) {
+            ctx.out += *value.text;
         }
 
-        template <>
-        void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
-            PrintString(value, ctx.out);
+        void PrintValue(std::nullptr_t, const PrintContext& ctx) {
+            ctx.out += "null"sv;
         }
 
-        template <>
-        void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
-            ctx.out << "null"sv;
+        void PrintValue(bool value, const PrintContext& ctx) {
+            ctx.out += value ? "true"sv : "false"sv;
         }
 
-        // В специализации шаблона PrintValue для типа bool параметр value передаётся
-        // по константной ссылке, как и в основном шаблоне.
-        // В качестве альтернативы можно использовать перегрузку:
-        // void PrintValue(bool value, const PrintContext& ctx);
-        template <>
-        void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
-            ctx.out << (value ? "true"sv : "false"sv);
+        void PrintValue(int value, const PrintContext& ctx) {
+            char buffer[16];
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            ctx.out.append(buffer, result.ptr);
         }
 
-        template <>
-        void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
-            std::ostream& out = ctx.out;
-            out << "[\n"sv;
+        // В обычном режиме число печатается как std::ostream << value (%g с
+        // точностью 6), в компактном - кратчайшей точно восстановимой записью
+        void PrintValue(double value, const PrintContext& ctx) {
+            char buffer[32];
+            const auto result = ctx.IsCompact()
+                ? std::to_chars(buffer, buffer + sizeof(buffer), value)
+                : std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+            ctx.out.append(buffer, result.ptr);
+        }
+
+        void PrintValue(const Array& nodes, const PrintContext& ctx) {
+            std::string& out = ctx.out;
+            if (ctx.IsCompact()) {
+                out.push_back('[');
+                bool first = true;
+                for (const Node& node : nodes) {
+                    if (!first) {
+                        out.push_back(',');
+                    }
+                    first = false;
+                    PrintNode(node, ctx);
+                }
+                out.push_back(']');
+                return;
+            }
+
+            out += "[\n"sv;
             bool first = true;
             auto inner_ctx = ctx.Indented();
             for (const Node& node : nodes) {
@@ -313,20 +397,35 @@ namespace json {
                     first = false;
                 }
                 else {
-                    out << ",\n"sv;
+                    out += ",\n"sv;
                 }
                 inner_ctx.PrintIndent();
                 PrintNode(node, inner_ctx);
             }
-            out.put('\n');
+            out.push_back('\n');
             ctx.PrintIndent();
-            out.put(']');
+            out.push_back(']');
         }
 
-        template <>
-        void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
-            std::ostream& out = ctx.out;
-            out << "{\n"sv;
+        void PrintValue(const Dict& nodes, const PrintContext& ctx) {
+            std::string& out = ctx.out;
+            if (ctx.IsCompact()) {
+                out.push_back('{');
+                bool first = true;
+                for (const auto& [key, node] : nodes) {
+                    if (!first) {
+                        out.push_back(',');
+                    }
+                    first = false;
+                    PrintString(key, out);
+                    out.push_back(':');
+                    PrintNode(node, ctx);
+                }
+                out.push_back('}');
+                return;
+            }
+
+            out += "{\n"sv;
             bool first = true;
             auto inner_ctx = ctx.Indented();
             for (const auto& [key, node] : nodes) {
@@ -334,16 +433,16 @@ namespace json {
                     first = false;
                 }
                 else {
-                    out << ",\n"sv;
+                    out += ",\n"sv;
                 }
                 inner_ctx.PrintIndent();
-                PrintString(key, ctx.out);
-                out << ": "sv;
+                PrintString(key, out);
+                out += ": "sv;
                 PrintNode(node, inner_ctx);
             }
-            out.put('\n');
+            out.push_back('\n');
             ctx.PrintIndent();
-            out.put('}');
+            out.push_back('}');
         }
 
         void PrintNode(const Node& node, const PrintContext& ctx) {
@@ -356,12 +455,342 @@ namespace json {
 
     }  // namespace
 
+    void NodeBuilder::StartObject() {
+        stack_.emplace_back(Dict{});
+    }
+
+    void NodeBuilder::Key(std::string_view key) {
+        std::string key_str(key);
+        const Dict& dict = std::get<Dict>(stack_.back().GetValue());
+        if (dict.find(key_str) != dict.end()) {
+            throw ParsingError("Duplicate key '"s + key_str + "' have been found");
+        }
+        keys_.push_back(std::move(key_str));
+    }
+
+    void NodeBuilder::EndObject() {
+        Node node = std::move(stack_.back());
+        stack_.pop_back();
+        AddNode(std::move(node));
+    }
+
+    void NodeBuilder::StartArray() {
+        stack_.emplace_back(Array{});
+    }
+
+    void NodeBuilder::EndArray() {
+        EndObject();
+    }
+
+    void NodeBuilder::Null() {
+        AddNode(nullptr);
+    }
+
+    void NodeBuilder::Bool(bool value) {
+        AddNode(value);
+    }
+
+    void NodeBuilder::Int(int value) {
+        AddNode(value);
+    }
+
+    void NodeBuilder::Double(double value) {
+        AddNode(value);
+    }
+
+    void NodeBuilder::String(std::string_view value) {
+        AddNode(std::string(value));
+    }
+
+    Node NodeBuilder::Extract() {
+        return std::move(root_);
+    }
+
+    void NodeBuilder::AddNode(Node node) {
+        if (stack_.empty()) {
+            root_ = std::move(node);
+            return;
+        }
+        Node::Value& parent = stack_.back().GetValue();
+        if (Array* array = std::get_if<Array>(&parent)) {
+            array->push_back(std::move(node));
+        }
+        else {
+            std::get<Dict>(parent).emplace(std::move(keys_.back()), std::move(node));
+            keys_.pop_back();
+        }
+    }
+
+    std::string ReadAll(std::istream& input) {
+        std::string buffer;
+        char block[1 << 16];
+        while (input.read(block, sizeof(block)) || input.gcount() > 0) {
+            buffer.append(block, static_cast<size_t>(input.gcount()));
+        }
+        return buffer;
+    }
+
+    void Parse(std::string_view input, Handler& handler) {
+        Parser parser(input.data(), input.data() + input.size(), handler);
+        parser.ParseNode();
+    }
+
+    bool ParseWhole(std::string_view input, Handler& handler) {
+        Parser parser(input.data(), input.data() + input.size(), handler);
+        parser.ParseNode();
+        return parser.IsConsumed();
+    }
+
+    void Parse(std::istream& input, Handler& handler) {
+        const std::string buffer = ReadAll(input);
+        Parse(buffer, handler);
+    }
+
+    StructureScanner::StructureScanner(std::string_view input)
+        : begin_(input.data()) {
+        if (input.size() >= INDEX_MIN_INPUT_SIZE && input.size() <= UINT32_MAX) {
+            index_.emplace(input);
+        }
+    }
+
+    const char* StructureScanner::SkipValue(const char* pos, const char* end) {
+        if (*pos == '"') {
+            return SkipString(pos, end);
+        }
+        if (*pos != '{' && *pos != '[') {
+            while (pos != end && !IsSpace(*pos) && *pos != ',' && *pos != ']' && *pos != '}') {
+                ++pos;
+            }
+            return pos;
+        }
+
+        int depth = 0;
+        if (index_) {
+            // Скобки ищутся среди лексем индекса: строки в нём уже пропущены
+            const std::vector<uint32_t>& positions = index_->GetPositions();
+            const auto offset = static_cast<uint32_t>(pos - begin_);
+            auto token = std::lower_bound(positions.begin() + next_token_, positions.end(), offset);
+            for (; token != positions.end(); ++token) {
+                const char c = begin_[*token];
+                if (c == '{' || c == '[') {
+                    ++depth;
+                }
+                else if ((c == '}' || c == ']') && --depth == 0) {
+                    next_token_ = token + 1 - positions.begin();
+                    return begin_ + *token + 1;
+                }
+            }
+            return nullptr;
+        }
+
+        for (; pos != end; ++pos) {
+            const char c = *pos;
+            if (c == '"') {
+                pos = SkipString(pos, end);
+                if (!pos) {
+                    return nullptr;
+                }
+                --pos;
+            }
+            else if (c == '{' || c == '[') {
+                ++depth;
+            }
+            else if ((c == '}' || c == ']') && --depth == 0) {
+                return pos + 1;
+            }
+        }
+        return nullptr;
+    }
+
+    std::optional<std::vector<MemberSpan>> StructureScanner::ScanObject(std::string_view value) {
+        const char* const end = value.data() + value.size();
+        const char* pos = SkipSpaces(value.data(), end);
+        if (pos == end || *pos != '{') {
+            return std::nullopt;
+        }
+        ++pos;
+        RewindTo(pos);
+
+        std::vector<MemberSpan> members;
+        while (true) {
+            pos = SkipSpaces(pos, end);
+            if (pos == end) {
+                return std::nullopt;
+            }
+            if (*pos == '}') {
+                return members;
+            }
+            if (*pos == ',') {
+                ++pos;
+                continue;
+            }
+            if (*pos != '"') {
+                return std::nullopt;
+            }
+
+            const char* key_end = SkipString(pos, end);
+            if (!key_end) {
+                return std::nullopt;
+            }
+            const std::string_view key(pos + 1, static_cast<size_t>(key_end - pos - 2));
+            pos = SkipSpaces(key_end, end);
+            if (pos == end || *pos != ':') {
+                return std::nullopt;
+            }
+            pos = SkipSpaces(pos + 1, end);
+            const char* value_end = pos != end ? SkipValue(pos, end) : nullptr;
+            if (!value_end || value_end == pos || value_end > end) {
+                return std::nullopt;
+            }
+            members.push_back({ key, { pos, static_cast<size_t>(value_end - pos) } });
+            pos = value_end;
+        }
+    }
+
+    std::optional<std::vector<std::string_view>> StructureScanner::ScanArray(std::string_view value) {
+        const char* const end = value.data() + value.size();
+        const char* pos = SkipSpaces(value.data(), end);
+        if (pos == end || *pos != '[') {
+            return std::nullopt;
+        }
+        ++pos;
+        RewindTo(pos);
+
+        std::vector<std::string_view> items;
+        while (true) {
+            pos = SkipSpaces(pos, end);
+            if (pos == end) {
+                return std::nullopt;
+            }
+            if (*pos == ']') {
+                return items;
+            }
+            if (*pos == ',') {
+                ++pos;
+                continue;
+            }
+
+            const char* value_end = SkipValue(pos, end);
+            if (!value_end || value_end == pos || value_end > end) {
+                return std::nullopt;
+            }
+            items.emplace_back(pos, static_cast<size_t>(value_end - pos));
+            pos = value_end;
+        }
+    }
+
+    void StructureScanner::RewindTo(const char* pos) {
+        if (index_) {
+            const std::vector<uint32_t>& positions = index_->GetPositions();
+            next_token_ = std::lower_bound(positions.begin(), positions.end(),
+                static_cast<uint32_t>(pos - begin_)) - positions.begin();
+        }
+    }
+
+    std::optional<std::vector<MemberSpan>> ScanObject(std::string_view input) {
+        return StructureScanner(input).ScanObject(input);
+    }
+
+    std::optional<std::vector<std::string_view>> ScanArray(std::string_view input) {
+        return StructureScanner(input).ScanArray(input);
+    }
+
+    Document Load(std::string_view input) {
+        NodeBuilder builder;
+        Parse(input, builder);
+        return Document{ builder.Extract() };
+    }
+
     Document Load(std::istream& input) {
-        return Document{ LoadNode(input) };
+        const std::string buffer = ReadAll(input);
+        return Load(buffer);
+    }
+
+    void PrintString(std::string_view value, std::string& out) {
+        out.push_back('"');
+        const char* pos = value.data();
+        const char* const end = pos + value.size();
+        while (pos != end) {
+            // Участок без специальных символов копируется целиком
+            const char* run_end = pos;
+            while (run_end != end && *run_end != '\r' && *run_end != '\n' && *run_end != '\t'
+                && *run_end != '"' && *run_end != '\\') {
+                ++run_end;
+            }
+            out.append(pos, run_end);
+            if (run_end == end) {
+                break;
+            }
+            switch (*run_end) {
+            case '\r':
+                out += "\\r"sv;
+                break;
+            case '\n':
+                out += "\\n"sv;
+                break;
+            case '\t':
+                out += "\\t"sv;
+                break;
+            default:
+                // Символы " и \ выводятся как \" или \\, соответственно
+                out.push_back('\\');
+                out.push_back(*run_end);
+                break;
+            }
+            pos = run_end + 1;
+        }
+        out.push_back('"');
+    }
+
+    void Print(const Document& doc, std::string& buffer, PrintMode mode) {
+        PrintNode(doc.GetRoot(), PrintContext{ buffer, mode });
+    }
+
+    void Print(const Document& doc, std::ostream& output, PrintMode mode) {
+        std::string buffer;
+        Print(doc, buffer, mode);
+        output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+
+    ArrayWriter::ArrayWriter(std::ostream& output, PrintMode mode)
+        : output_(output)
+        , mode_(mode) {
+        buffer_.reserve(FLUSH_THRESHOLD + FLUSH_THRESHOLD / 4);
+        buffer_.push_back('[');
+    }
+
+    void ArrayWriter::Write(const Node& node) {
+        if (mode_ == PrintMode::COMPACT) {
+            if (!first_) {
+                buffer_.push_back(',');
+            }
+            PrintNode(node, PrintContext{ buffer_, mode_ });
+        }
+        else {
+            buffer_ += first_ ? "\n    "sv : ",\n    "sv;
+            PrintNode(node, PrintContext{ buffer_, mode_, 4, 4 });
+        }
+        first_ = false;
+
+        if (buffer_.size() >= FLUSH_THRESHOLD) {
+            Flush();
+        }
+    }
+
+    void ArrayWriter::Finish() {
+        // Пустой массив печатается так же, как в Print: "[\n\n]"
+        if (mode_ == PrintMode::COMPACT) {
+            buffer_.push_back(']');
+        }
+        else {
+            buffer_ += first_ ? "\n\n]"sv : "\n]"sv;
+        }
+        Flush();
     }
 
-    void Print(const Document& doc, std::ostream& output) {
-        PrintNode(doc.GetRoot(), PrintContext{ output });
+    void ArrayWriter::Flush() {
+        output_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
     }
 
 }  // namespace json
\ No newline at end of file
@@ -1,8 +1,13 @@
 #pragma once
 
+#include "json_structural_index.h"
+
 #include <iostream>
 #include <map>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -12,13 +17,24 @@ namespace json {
     using Dict = std::map<std::string, Node>;
     using Array = std::vector<Node>;
 
+    // Уже сериализованный фрагмент JSON, который печатается как есть в любом
+    // режиме. Текст разделяется между копиями узла, поэтому однажды
+    // подготовленное большое значение не копируется и не экранируется повторно
+    struct RawJson {
+        std::shared_ptr<const std::string> text;
+
+        bool operator==(const RawJson& rhs) const {
+            return *text == *rhs.text;
+        }
+    };
+
     class ParsingError : public std::runtime_error {
     public:
         using runtime_error::runtime_error;
     };
 
     class Node final
-        : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string> {
+        : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string, RawJson> {
     public:
         using variant::variant;
         using Value = variant;
@@ -139,8 +155,128 @@ namespace json {
         return !(lhs == rhs);
     }
 
+    // Получатель событий потокового разбора: вызовы приходят в порядке
+    // следования элементов в документе. Строки и ключи без экранированных
+    // символов указывают прямо во входной буфер Parse и живут вместе с ним,
+    // остальные действительны только до возврата из обработчика
+    class Handler {
+    public:
+        virtual ~Handler() = default;
+
+        virtual void StartObject() = 0;
+        virtual void Key(std::string_view key) = 0;
+        virtual void EndObject() = 0;
+        virtual void StartArray() = 0;
+        virtual void EndArray() = 0;
+        virtual void Null() = 0;
+        virtual void Bool(bool value) = 0;
+        virtual void Int(int value) = 0;
+        virtual void Double(double value) = 0;
+        virtual void String(std::string_view value) = 0;
+    };
+
+    // Собирает из событий разбора дерево Node
+    class NodeBuilder final : public Handler {
+    public:
+        void StartObject() override;
+        void Key(std::string_view key) override;
+        void EndObject() override;
+        void StartArray() override;
+        void EndArray() override;
+        void Null() override;
+        void Bool(bool value) override;
+        void Int(int value) override;
+        void Double(double value) override;
+        void String(std::string_view value) override;
+
+        Node Extract();
+
+    private:
+        void AddNode(Node node);
+
+        Node root_;
+        std::vector<Node> stack_;
+        std::vector<std::string> keys_;
+    };
+
+    // Читает поток целиком крупными блоками, разбор идёт уже по буферу
+    std::string ReadAll(std::istream& input);
+
+    void Parse(std::istream& input, Handler& handler);
+    void Parse(std::string_view input, Handler& handler);
+    // Как Parse, но сообщает, занимает ли значение input целиком: false, если
+    // после него остались символы, кроме пробельных
+    bool ParseWhole(std::string_view input, Handler& handler);
+
     Document Load(std::istream& input);
+    Document Load(std::string_view input);
 
-    void Print(const Document& doc, std::ostream& output);
+    // Предварительный просмотр структуры без полного разбора: находит границы
+    // значений верхнего уровня, учитывая только строки и скобки. Возвращает
+    // nullopt, если уже на верхнем уровне текст не похож на объект или массив;
+    // ошибки внутри значений обнаружит только их разбор
+    struct MemberSpan {
+        // Ключ как есть, без раскрытия экранированных символов
+        std::string_view key;
+        std::string_view value;
+    };
+
+    // Просматривает значения одного входного текста. На больших входах один
+    // раз строится структурный индекс, и вложенные массивы и словари
+    // пропускаются по его лексемам, а не посимвольно. Передаваемые value
+    // должны быть частями input
+    class StructureScanner {
+    public:
+        explicit StructureScanner(std::string_view input);
+
+        std::optional<std::vector<MemberSpan>> ScanObject(std::string_view value);
+        std::optional<std::vector<std::string_view>> ScanArray(std::string_view value);
+
+    private:
+        const char* SkipValue(const char* pos, const char* end);
+        void RewindTo(const char* pos);
+
+        const char* begin_;
+        std::optional<StructuralIndex> index_;
+        // Первая лексема индекса, ещё не пройденная текущим просмотром
+        size_t next_token_ = 0;
+    };
+
+    std::optional<std::vector<MemberSpan>> ScanObject(std::string_view input);
+    std::optional<std::vector<std::string_view>> ScanArray(std::string_view input);
+
+    // PRETTY - с переводами строк и отступами, COMPACT - без пробельных символов
+    // и с кратчайшей точной записью дробных чисел
+    enum class PrintMode {
+        PRETTY,
+        COMPACT
+    };
+
+    void Print(const Document& doc, std::ostream& output, PrintMode mode = PrintMode::PRETTY);
+    // Дописывает value в конец out в виде строкового литерала JSON
+    void PrintString(std::string_view value, std::string& out);
+    // Дописывает текст документа в конец buffer
+    void Print(const Document& doc, std::string& buffer, PrintMode mode = PrintMode::PRETTY);
+
+    // Печатает массив по одному элементу, не собирая его целиком в памяти.
+    // Вывод совпадает с Print для Array из тех же элементов. Текст копится в
+    // буфере и сбрасывается в output, когда буфер заполнится, и в Finish
+    class ArrayWriter {
+    public:
+        explicit ArrayWriter(std::ostream& output, PrintMode mode = PrintMode::PRETTY);
+
+        void Write(const Node& node);
+        void Finish();
+
+    private:
+        static constexpr size_t FLUSH_THRESHOLD = 1 << 20;
+
+        void Flush();
+
+        std::ostream& output_;
+        PrintMode mode_;
+        std::string buffer_;
+        bool first_ = true;
+    };
 
 }  // namespace json
\ No newline at end of file
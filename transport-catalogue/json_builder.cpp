@@ -168,6 +168,10 @@ namespace json {
             return Node(std::get<Array>(value));
         }
 
+        if (std::holds_alternative<RawJson>(value)) {
+            return Node(std::get<RawJson>(value));
+        }
+
         return {};
     }
 
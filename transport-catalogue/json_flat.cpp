@@ -0,0 +1,263 @@
+#include "json_flat.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+namespace json {
+
+    using namespace std::literals;
+
+    void* Arena::Allocate(size_t size, size_t alignment) {
+        auto aligned = [alignment](char* pos) {
+            const auto address = reinterpret_cast<uintptr_t>(pos);
+            return pos + ((alignment - address % alignment) % alignment);
+        };
+
+        char* begin = pos_ ? aligned(pos_) : nullptr;
+        if (!begin || begin + size > end_) {
+            // Каждый следующий блок вдвое больше, чтобы число блоков росло логарифмически
+            const size_t block_size = std::max(next_block_size_, size + alignment);
+            blocks_.push_back(std::make_unique<char[]>(block_size));
+            pos_ = blocks_.back().get();
+            end_ = pos_ + block_size;
+            allocated_ += block_size;
+            next_block_size_ = block_size * 2;
+            begin = aligned(pos_);
+        }
+        pos_ = begin + size;
+        return begin;
+    }
+
+    std::string_view Arena::CopyString(std::string_view value) {
+        if (value.empty()) {
+            return {};
+        }
+        char* data = AllocateArray<char>(value.size());
+        std::memcpy(data, value.data(), value.size());
+        return { data, value.size() };
+    }
+
+    size_t Arena::GetAllocatedBytes() const {
+        return allocated_;
+    }
+
+    FlatDict::const_iterator FlatDict::find(std::string_view key) const {
+        if (size_ <= LINEAR_SEARCH_LIMIT) {
+            return std::find_if(begin(), end(), [key](const FlatMember& member) {
+                return member.first == key;
+            });
+        }
+        auto it = std::lower_bound(begin(), end(), key, [](const FlatMember& member, std::string_view key) {
+            return member.first < key;
+        });
+        return it != end() && it->first == key ? it : end();
+    }
+
+    const FlatNode& FlatDict::at(std::string_view key) const {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("Key '"s + std::string(key) + "' is not found"s);
+        }
+        return it->second;
+    }
+
+    FlatNode FlatNode::MakeBool(bool value) {
+        FlatNode node;
+        node.type_ = Type::BOOL;
+        node.value_.bool_value = value;
+        return node;
+    }
+
+    FlatNode FlatNode::MakeInt(int value) {
+        FlatNode node;
+        node.type_ = Type::INT;
+        node.value_.int_value = value;
+        return node;
+    }
+
+    FlatNode FlatNode::MakeDouble(double value) {
+        FlatNode node;
+        node.type_ = Type::DOUBLE;
+        node.value_.double_value = value;
+        return node;
+    }
+
+    FlatNode FlatNode::MakeString(std::string_view value) {
+        FlatNode node;
+        node.type_ = Type::STRING;
+        node.size_ = static_cast<uint32_t>(value.size());
+        node.value_.chars = value.data();
+        return node;
+    }
+
+    FlatNode FlatNode::MakeArray(const FlatNode* items, size_t size) {
+        FlatNode node;
+        node.type_ = Type::ARRAY;
+        node.size_ = static_cast<uint32_t>(size);
+        node.value_.items = items;
+        return node;
+    }
+
+    FlatNode FlatNode::MakeDict(const FlatMember* members, size_t size) {
+        FlatNode node;
+        node.type_ = Type::DICT;
+        node.size_ = static_cast<uint32_t>(size);
+        node.value_.members = members;
+        return node;
+    }
+
+    bool FlatNode::AsBool() const {
+        if (!IsBool()) {
+            throw std::logic_error("Not a bool"s);
+        }
+        return value_.bool_value;
+    }
+
+    int FlatNode::AsInt() const {
+        if (!IsInt()) {
+            throw std::logic_error("Not an int"s);
+        }
+        return value_.int_value;
+    }
+
+    double FlatNode::AsDouble() const {
+        if (!IsDouble()) {
+            throw std::logic_error("Not a double"s);
+        }
+        return IsPureDouble() ? value_.double_value : value_.int_value;
+    }
+
+    std::string_view FlatNode::AsString() const {
+        if (!IsString()) {
+            throw std::logic_error("Not a string"s);
+        }
+        return { value_.chars, size_ };
+    }
+
+    FlatArray FlatNode::AsArray() const {
+        if (!IsArray()) {
+            throw std::logic_error("Not an array"s);
+        }
+        return { value_.items, size_ };
+    }
+
+    FlatDict FlatNode::AsDict() const {
+        if (!IsDict()) {
+            throw std::logic_error("Not a dict"s);
+        }
+        return { value_.members, size_ };
+    }
+
+    FlatBuilder::FlatBuilder(std::string_view retained_input)
+        : retained_input_(retained_input) {
+    }
+
+    void FlatBuilder::StartObject() {
+        frames_.push_back({ true, members_.size() });
+    }
+
+    void FlatBuilder::Key(std::string_view key) {
+        members_.emplace_back(Keep(key), FlatNode{});
+    }
+
+    void FlatBuilder::EndObject() {
+        const size_t first = frames_.back().first;
+        frames_.pop_back();
+
+        const size_t size = members_.size() - first;
+        FlatMember* members = arena_.AllocateArray<FlatMember>(size);
+        std::uninitialized_copy(members_.begin() + first, members_.end(), members);
+        members_.resize(first);
+
+        // stable_sort сохраняет порядок повторяющихся ключей, чтобы сообщить о первом
+        std::stable_sort(members, members + size, [](const FlatMember& lhs, const FlatMember& rhs) {
+            return lhs.first < rhs.first;
+        });
+        auto duplicate = std::adjacent_find(members, members + size, [](const FlatMember& lhs, const FlatMember& rhs) {
+            return lhs.first == rhs.first;
+        });
+        if (duplicate != members + size) {
+            throw ParsingError("Duplicate key '"s + std::string(duplicate->first) + "' have been found");
+        }
+
+        AddNode(FlatNode::MakeDict(members, size));
+    }
+
+    void FlatBuilder::StartArray() {
+        frames_.push_back({ false, items_.size() });
+    }
+
+    void FlatBuilder::EndArray() {
+        const size_t first = frames_.back().first;
+        frames_.pop_back();
+
+        const size_t size = items_.size() - first;
+        FlatNode* items = arena_.AllocateArray<FlatNode>(size);
+        std::uninitialized_copy(items_.begin() + first, items_.end(), items);
+        items_.resize(first);
+
+        AddNode(FlatNode::MakeArray(items, size));
+    }
+
+    void FlatBuilder::Null() {
+        AddNode(FlatNode{});
+    }
+
+    void FlatBuilder::Bool(bool value) {
+        AddNode(FlatNode::MakeBool(value));
+    }
+
+    void FlatBuilder::Int(int value) {
+        AddNode(FlatNode::MakeInt(value));
+    }
+
+    void FlatBuilder::Double(double value) {
+        AddNode(FlatNode::MakeDouble(value));
+    }
+
+    void FlatBuilder::String(std::string_view value) {
+        AddNode(FlatNode::MakeString(Keep(value)));
+    }
+
+    FlatDocument FlatBuilder::Extract() {
+        return FlatDocument{ std::move(arena_), root_ };
+    }
+
+    void FlatBuilder::AddNode(FlatNode node) {
+        if (frames_.empty()) {
+            root_ = node;
+        }
+        else if (frames_.back().is_dict) {
+            members_.back().second = node;
+        }
+        else {
+            items_.push_back(node);
+        }
+    }
+
+    std::string_view FlatBuilder::Keep(std::string_view value) {
+        // std::less задаёт полный порядок и для указателей на разные объекты
+        const std::less<const char*> less;
+        const char* begin = retained_input_.data();
+        const char* end = begin + retained_input_.size();
+        if (!less(value.data(), begin) && !less(end, value.data() + value.size())) {
+            return value;
+        }
+        return arena_.CopyString(value);
+    }
+
+    FlatDocument LoadFlat(std::string_view input) {
+        FlatBuilder builder;
+        Parse(input, builder);
+        return builder.Extract();
+    }
+
+    FlatDocument LoadFlat(std::istream& input) {
+        FlatBuilder builder;
+        Parse(input, builder);
+        return builder.Extract();
+    }
+
+}  // namespace json
\ No newline at end of file
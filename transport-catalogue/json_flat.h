@@ -0,0 +1,251 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+    // Монотонный распределитель: память выделяется из крупных блоков и
+    // освобождается только целиком вместе с ареной
+    class Arena {
+    public:
+        Arena() = default;
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+        Arena(Arena&&) = default;
+        Arena& operator=(Arena&&) = default;
+
+        void* Allocate(size_t size, size_t alignment);
+        std::string_view CopyString(std::string_view value);
+
+        template <typename T>
+        T* AllocateArray(size_t count) {
+            return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        size_t GetAllocatedBytes() const;
+
+    private:
+        static constexpr size_t MIN_BLOCK_SIZE = 64 * 1024;
+
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        char* pos_ = nullptr;
+        char* end_ = nullptr;
+        size_t allocated_ = 0;
+        size_t next_block_size_ = MIN_BLOCK_SIZE;
+    };
+
+    class FlatNode;
+    class FlatArray;
+    class FlatDict;
+    using FlatMember = std::pair<std::string_view, FlatNode>;
+
+    // Узел документа, размещённого в арене. Строки, массивы и словари не
+    // владеют памятью и действительны, пока жив FlatDocument
+    class FlatNode {
+    public:
+        enum class Type : unsigned char {
+            NULL_VALUE,
+            BOOL,
+            INT,
+            DOUBLE,
+            STRING,
+            ARRAY,
+            DICT
+        };
+
+        FlatNode() = default;
+
+        static FlatNode MakeBool(bool value);
+        static FlatNode MakeInt(int value);
+        static FlatNode MakeDouble(double value);
+        static FlatNode MakeString(std::string_view value);
+        static FlatNode MakeArray(const FlatNode* items, size_t size);
+        static FlatNode MakeDict(const FlatMember* members, size_t size);
+
+        Type GetType() const {
+            return type_;
+        }
+
+        bool IsNull() const {
+            return type_ == Type::NULL_VALUE;
+        }
+        bool IsBool() const {
+            return type_ == Type::BOOL;
+        }
+        bool IsInt() const {
+            return type_ == Type::INT;
+        }
+        bool IsPureDouble() const {
+            return type_ == Type::DOUBLE;
+        }
+        bool IsDouble() const {
+            return IsInt() || IsPureDouble();
+        }
+        bool IsString() const {
+            return type_ == Type::STRING;
+        }
+        bool IsArray() const {
+            return type_ == Type::ARRAY;
+        }
+        bool IsDict() const {
+            return type_ == Type::DICT;
+        }
+
+        bool AsBool() const;
+        int AsInt() const;
+        double AsDouble() const;
+        std::string_view AsString() const;
+        FlatArray AsArray() const;
+        FlatDict AsDict() const;
+
+    private:
+        Type type_ = Type::NULL_VALUE;
+        uint32_t size_ = 0;
+        union {
+            bool bool_value;
+            int int_value;
+            double double_value;
+            const char* chars;
+            const FlatNode* items;
+            const FlatMember* members;
+        } value_{};
+    };
+
+    // Массив - непрерывный участок узлов в арене
+    class FlatArray {
+    public:
+        FlatArray() = default;
+        FlatArray(const FlatNode* data, size_t size)
+            : data_(data)
+            , size_(size) {
+        }
+
+        const FlatNode* begin() const {
+            return data_;
+        }
+        const FlatNode* end() const {
+            return data_ + size_;
+        }
+        size_t size() const {
+            return size_;
+        }
+        bool empty() const {
+            return size_ == 0;
+        }
+        const FlatNode& operator[](size_t index) const {
+            return data_[index];
+        }
+
+    private:
+        const FlatNode* data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    // Словарь - непрерывный участок пар, упорядоченных по ключу. Небольшие
+    // словари просматриваются линейно, остальные - двоичным поиском
+    class FlatDict {
+    public:
+        using const_iterator = const FlatMember*;
+
+        FlatDict() = default;
+        FlatDict(const FlatMember* data, size_t size)
+            : data_(data)
+            , size_(size) {
+        }
+
+        const_iterator begin() const {
+            return data_;
+        }
+        const_iterator end() const {
+            return data_ + size_;
+        }
+        size_t size() const {
+            return size_;
+        }
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        const_iterator find(std::string_view key) const;
+        size_t count(std::string_view key) const {
+            return find(key) != end() ? 1 : 0;
+        }
+        const FlatNode& at(std::string_view key) const;
+
+    private:
+        static constexpr size_t LINEAR_SEARCH_LIMIT = 8;
+
+        const FlatMember* data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    class FlatDocument {
+    public:
+        FlatDocument() = default;
+        FlatDocument(Arena arena, FlatNode root)
+            : arena_(std::move(arena))
+            , root_(root) {
+        }
+
+        const FlatNode& GetRoot() const {
+            return root_;
+        }
+
+        const Arena& GetArena() const {
+            return arena_;
+        }
+
+    private:
+        Arena arena_;
+        FlatNode root_;
+    };
+
+    // Собирает из событий разбора FlatDocument. Элементы незакрытых массивов и
+    // словарей копятся на общих стеках и переносятся в арену одним участком.
+    // Если передан retained_input - входной буфер, который переживёт документ,
+    // - строки, указывающие в него, не копируются в арену
+    class FlatBuilder final : public Handler {
+    public:
+        explicit FlatBuilder(std::string_view retained_input = {});
+
+        void StartObject() override;
+        void Key(std::string_view key) override;
+        void EndObject() override;
+        void StartArray() override;
+        void EndArray() override;
+        void Null() override;
+        void Bool(bool value) override;
+        void Int(int value) override;
+        void Double(double value) override;
+        void String(std::string_view value) override;
+
+        FlatDocument Extract();
+
+    private:
+        struct Frame {
+            bool is_dict;
+            size_t first;
+        };
+
+        void AddNode(FlatNode node);
+        std::string_view Keep(std::string_view value);
+
+        std::string_view retained_input_;
+        Arena arena_;
+        FlatNode root_;
+        std::vector<Frame> frames_;
+        std::vector<FlatNode> items_;
+        std::vector<FlatMember> members_;
+    };
+
+    FlatDocument LoadFlat(std::string_view input);
+    FlatDocument LoadFlat(std::istream& input);
+
+}  // namespace json
\ No newline at end of file
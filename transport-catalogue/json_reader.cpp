@@ -1,28 +1,551 @@
 #include "json_reader.h"
 #include "json_builder.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
 
 using namespace std::literals;
 
+// Сколько ответов на поток пула может быть вычислено впрок, пока печатаются
+// предыдущие
+constexpr size_t RESPONSES_IN_FLIGHT_PER_THREAD = 8;
+
 enum ColorTypeRGB {
     TipeRgb = 3,
     TipeRgb_A = 4
 };
 
-const json::Node& JsonReader::GetBaseRequests() const {
+namespace {
 
-    const auto& root = input_.GetRoot().AsDict();
+    struct BaseRequest {
+        std::string_view type;
+        std::string_view name;
+        geo::Coordinates coordinates = { 0.0, 0.0 };
+        std::vector<std::pair<std::string_view, int>> road_distances;
+        std::vector<std::string_view> stops;
+        bool is_roundtrip = false;
+    };
 
-    auto it = root.find("base_requests");
+    // Собирает запросы base_requests из событий разбора. Глубина отсчитывается
+    // так, что сами запросы лежат на уровне request_depth: 1 - разбирается
+    // отдельный запрос, 2 - массив запросов целиком. Входные данные проверяются
+    // с теми же ошибками, что и при чтении через дерево
+    class BaseRequestReader final : public json::Handler {
+    public:
+        BaseRequestReader(std::string_view input, int request_depth)
+            : input_(input)
+            , request_depth_(request_depth) {
+        }
 
-    if (it != root.end())
-    {
-        return it->second;
+        void StartObject() override {
+            CheckValue(Value::DICT);
+            if (++depth_ == request_depth_) {
+                request_ = BaseRequest{};
+                seen_fields_ = 0;
+            }
+        }
+
+        void Key(std::string_view key) override {
+            if (depth_ == request_depth_) {
+                field_ = ToField(key);
+                seen_fields_ |= Bit(field_);
+            }
+            else if (depth_ == request_depth_ + 1 && field_ == Field::ROAD_DISTANCES) {
+                distance_to_ = Keep(key);
+            }
+        }
+
+        void EndObject() override {
+            if (depth_-- == request_depth_) {
+                CheckRequiredFields();
+                requests_.push_back(std::move(request_));
+            }
+        }
+
+        void StartArray() override {
+            CheckValue(Value::ARRAY);
+            ++depth_;
+        }
+
+        void EndArray() override {
+            --depth_;
+        }
+
+        void Null() override {
+            CheckValue(Value::NULL_VALUE);
+        }
+
+        void Bool(bool value) override {
+            CheckValue(Value::BOOL);
+            if (depth_ == request_depth_ && field_ == Field::IS_ROUNDTRIP) {
+                request_.is_roundtrip = value;
+            }
+        }
+
+        void Int(int value) override {
+            CheckValue(Value::INT);
+            if (depth_ == request_depth_ + 1 && field_ == Field::ROAD_DISTANCES) {
+                request_.road_distances.emplace_back(distance_to_, value);
+            }
+            else {
+                SetCoordinate(value);
+            }
+        }
+
+        void Double(double value) override {
+            CheckValue(Value::DOUBLE);
+            SetCoordinate(value);
+        }
+
+        void String(std::string_view value) override {
+            CheckValue(Value::STRING);
+            if (depth_ == request_depth_ && field_ == Field::TYPE) {
+                request_.type = Keep(value);
+            }
+            else if (depth_ == request_depth_ && field_ == Field::NAME) {
+                request_.name = Keep(value);
+            }
+            else if (depth_ == request_depth_ + 1 && field_ == Field::STOPS) {
+                request_.stops.push_back(Keep(value));
+            }
+        }
+
+        // Значение base_requests разобрано целиком
+        bool IsFinished() const {
+            return depth_ == 0;
+        }
+
+        std::vector<BaseRequest>& GetRequests() {
+            return requests_;
+        }
+
+    private:
+        enum class Field {
+            OTHER,
+            TYPE,
+            NAME,
+            LATITUDE,
+            LONGITUDE,
+            ROAD_DISTANCES,
+            STOPS,
+            IS_ROUNDTRIP
+        };
+
+        enum class Value {
+            NULL_VALUE,
+            BOOL,
+            INT,
+            DOUBLE,
+            STRING,
+            ARRAY,
+            DICT
+        };
+
+        static Field ToField(std::string_view key) {
+            static constexpr std::pair<std::string_view, Field> fields[] = {
+                { "type"sv, Field::TYPE },
+                { "name"sv, Field::NAME },
+                { "latitude"sv, Field::LATITUDE },
+                { "longitude"sv, Field::LONGITUDE },
+                { "road_distances"sv, Field::ROAD_DISTANCES },
+                { "stops"sv, Field::STOPS },
+                { "is_roundtrip"sv, Field::IS_ROUNDTRIP }
+            };
+            for (const auto& [name, field] : fields) {
+                if (name == key) {
+                    return field;
+                }
+            }
+            return Field::OTHER;
+        }
+
+        static unsigned Bit(Field field) {
+            return 1u << static_cast<unsigned>(field);
+        }
+
+        // Тип очередного значения сверяется с тем, что ожидается на его месте:
+        // base_requests - массив словарей, у известных полей запроса свой тип,
+        // road_distances - словарь целых, stops - массив строк
+        void CheckValue(Value value) const {
+            if (depth_ < request_depth_ - 1) {
+                if (value != Value::ARRAY) {
+                    throw std::logic_error("Not an array"s);
+                }
+            }
+            else if (depth_ == request_depth_ - 1) {
+                if (value != Value::DICT) {
+                    throw std::logic_error("Not a dict"s);
+                }
+            }
+            else if (depth_ == request_depth_) {
+                CheckFieldValue(value);
+            }
+            else if (depth_ == request_depth_ + 1) {
+                if (field_ == Field::ROAD_DISTANCES && value != Value::INT) {
+                    throw std::logic_error("Not an int"s);
+                }
+                if (field_ == Field::STOPS && value != Value::STRING) {
+                    throw std::logic_error("Not a string"s);
+                }
+            }
+        }
+
+        void CheckFieldValue(Value value) const {
+            switch (field_) {
+            case Field::TYPE:
+            case Field::NAME:
+                if (value != Value::STRING) {
+                    throw std::logic_error("Not a string"s);
+                }
+                break;
+            case Field::LATITUDE:
+            case Field::LONGITUDE:
+                if (value != Value::INT && value != Value::DOUBLE) {
+                    throw std::logic_error("Not a double"s);
+                }
+                break;
+            case Field::ROAD_DISTANCES:
+                if (value != Value::DICT) {
+                    throw std::logic_error("Not a dict"s);
+                }
+                break;
+            case Field::STOPS:
+                if (value != Value::ARRAY) {
+                    throw std::logic_error("Not an array"s);
+                }
+                break;
+            case Field::IS_ROUNDTRIP:
+                if (value != Value::BOOL) {
+                    throw std::logic_error("Not a bool"s);
+                }
+                break;
+            case Field::OTHER:
+                break;
+            }
+        }
+
+        void RequireField(Field field, std::string_view key) const {
+            if (!(seen_fields_ & Bit(field))) {
+                throw std::out_of_range("Key '"s + std::string(key) + "' is not found"s);
+            }
+        }
+
+        void CheckRequiredFields() const {
+            RequireField(Field::TYPE, "type"sv);
+            RequireField(Field::NAME, "name"sv);
+            if (request_.type == "Stop"sv) {
+                RequireField(Field::LATITUDE, "latitude"sv);
+                RequireField(Field::LONGITUDE, "longitude"sv);
+                RequireField(Field::ROAD_DISTANCES, "road_distances"sv);
+            }
+            else if (request_.type == "Bus"sv) {
+                RequireField(Field::STOPS, "stops"sv);
+                RequireField(Field::IS_ROUNDTRIP, "is_roundtrip"sv);
+            }
+        }
+
+        void SetCoordinate(double value) {
+            if (depth_ == request_depth_ && field_ == Field::LATITUDE) {
+                request_.coordinates.lat = value;
+            }
+            else if (depth_ == request_depth_ && field_ == Field::LONGITUDE) {
+                request_.coordinates.lng = value;
+            }
+        }
+
+        // Строки без экранирования указывают во входной буфер, который живёт
+        // дольше разбора; остальные приходится копировать
+        std::string_view Keep(std::string_view value) {
+            const std::less<const char*> less;
+            const char* end = input_.data() + input_.size();
+            if (!less(value.data(), input_.data()) && !less(end, value.data() + value.size())) {
+                return value;
+            }
+            return escaped_strings_.emplace_back(value);
+        }
+
+        std::string_view input_;
+        int request_depth_;
+        int depth_ = 0;
+        Field field_ = Field::OTHER;
+        // Поля текущего запроса, уже встретившиеся в нём
+        unsigned seen_fields_ = 0;
+        // Ключ road_distances, значение которого ещё не пришло
+        std::string_view distance_to_;
+        BaseRequest request_;
+        std::vector<BaseRequest> requests_;
+        std::deque<std::string> escaped_strings_;
+    };
+
+    // Обработчик событий разбора входного документа целиком: события внутри
+    // base_requests передаются BaseRequestReader, всё остальное собирается
+    // в FlatDocument
+    class InputHandler final : public json::Handler {
+    public:
+        explicit InputHandler(std::string_view input)
+            : base_requests_(input, 2)
+            , builder_(input) {
+        }
+
+        void StartObject() override {
+            if (in_base_requests_) {
+                base_requests_.StartObject();
+            }
+            else {
+                ++root_depth_;
+                builder_.StartObject();
+            }
+        }
+
+        void Key(std::string_view key) override {
+            if (in_base_requests_) {
+                base_requests_.Key(key);
+            }
+            else if (root_depth_ == 1 && key == "base_requests"sv) {
+                in_base_requests_ = true;
+            }
+            else {
+                builder_.Key(key);
+            }
+        }
+
+        void EndObject() override {
+            if (in_base_requests_) {
+                base_requests_.EndObject();
+                CheckBaseRequestsEnd();
+            }
+            else {
+                --root_depth_;
+                builder_.EndObject();
+            }
+        }
+
+        void StartArray() override {
+            if (in_base_requests_) {
+                base_requests_.StartArray();
+            }
+            else {
+                ++root_depth_;
+                builder_.StartArray();
+            }
+        }
+
+        void EndArray() override {
+            if (in_base_requests_) {
+                base_requests_.EndArray();
+                CheckBaseRequestsEnd();
+            }
+            else {
+                --root_depth_;
+                builder_.EndArray();
+            }
+        }
+
+        void Null() override {
+            if (in_base_requests_) {
+                base_requests_.Null();
+                CheckBaseRequestsEnd();
+            }
+            else {
+                builder_.Null();
+            }
+        }
+
+        void Bool(bool value) override {
+            if (in_base_requests_) {
+                base_requests_.Bool(value);
+                CheckBaseRequestsEnd();
+            }
+            else {
+                builder_.Bool(value);
+            }
+        }
+
+        void Int(int value) override {
+            if (in_base_requests_) {
+                base_requests_.Int(value);
+                CheckBaseRequestsEnd();
+            }
+            else {
+                builder_.Int(value);
+            }
+        }
+
+        void Double(double value) override {
+            if (in_base_requests_) {
+                base_requests_.Double(value);
+                CheckBaseRequestsEnd();
+            }
+            else {
+                builder_.Double(value);
+            }
+        }
+
+        void String(std::string_view value) override {
+            if (in_base_requests_) {
+                base_requests_.String(value);
+                CheckBaseRequestsEnd();
+            }
+            else {
+                builder_.String(value);
+            }
+        }
+
+        BaseRequestReader& GetBaseRequests() {
+            return base_requests_;
+        }
+
+        json::FlatDocument ExtractDocument() {
+            return builder_.Extract();
+        }
+
+    private:
+        void CheckBaseRequestsEnd() {
+            if (base_requests_.IsFinished()) {
+                in_base_requests_ = false;
+            }
+        }
+
+        BaseRequestReader base_requests_;
+        bool in_base_requests_ = false;
+
+        json::FlatBuilder builder_;
+        int root_depth_ = 0;
+    };
+
+    // Остановки добавляются первыми; расстояния и маршруты - после всех
+    // остановок, так как могут ссылаться на описанные ниже
+    void FillCatalogue(const std::vector<BaseRequest>& requests, transport_catalogue::TransportCatalogue& catalogue) {
+        for (const BaseRequest& request : requests) {
+            if (request.type == "Stop"sv) {
+                catalogue.AddStop(request.name, request.coordinates);
+            }
+        }
+
+        std::vector<transport_catalogue::StopDistance> distances;
+        for (const BaseRequest& request : requests) {
+            if (request.type == "Stop"sv) {
+                const transport_catalogue::Stop* from = catalogue.FindStop(request.name);
+                for (const auto& [to_name, distance] : request.road_distances) {
+                    // Расстояние до остановки, которой нет в справочнике, не
+                    // может понадобиться ни одному маршруту
+                    if (const transport_catalogue::Stop* to = catalogue.FindStop(to_name)) {
+                        distances.push_back({ from, to, distance });
+                    }
+                }
+            }
+        }
+        catalogue.SetDistances(distances);
+
+        std::vector<const transport_catalogue::Stop*> stops;
+        for (const BaseRequest& request : requests) {
+            if (request.type == "Bus"sv) {
+                stops.clear();
+                for (const auto& stop_name : request.stops) {
+                    stops.push_back(catalogue.FindStop(stop_name));
+                }
+                catalogue.AddRoute(request.name, stops, request.is_roundtrip);
+            }
+        }
+        catalogue.PrecomputeBusStats();
     }
 
-    return dummy_;
+    json::FlatDocument ReadInputSequential(std::string_view input, transport_catalogue::TransportCatalogue& catalogue) {
+        InputHandler handler(input);
+        json::Parse(input, handler);
+        FillCatalogue(handler.GetBaseRequests().GetRequests(), catalogue);
+        return handler.ExtractDocument();
+    }
+
+    // Запросы base_requests независимы, поэтому после предварительного просмотра
+    // структуры массив делится по границам запросов, части разбираются
+    // параллельно и сливаются в исходном порядке. Если текст на верхнем уровне
+    // устроен неожиданно, разбор идёт последовательно и сообщит об ошибке
+    json::FlatDocument ReadInput(std::string_view input, transport_catalogue::TransportCatalogue& catalogue) {
+        json::StructureScanner scanner(input);
+        const auto members = scanner.ScanObject(input);
+        if (!members) {
+            return ReadInputSequential(input, catalogue);
+        }
+
+        std::optional<std::vector<std::string_view>> requests_text;
+        for (const json::MemberSpan& member : *members) {
+            if (member.key.find('\\') != std::string_view::npos) {
+                return ReadInputSequential(input, catalogue);
+            }
+            if (member.key == "base_requests"sv) {
+                requests_text = scanner.ScanArray(member.value);
+                if (!requests_text) {
+                    return ReadInputSequential(input, catalogue);
+                }
+            }
+        }
+
+        // Просмотр структуры считает значением всё до разделителя, поэтому
+        // часть, прочитанная не до конца (например, 01), означает ошибку,
+        // о которой точно сообщит только последовательный разбор. Каталог к
+        // этому моменту ещё не тронут
+        std::deque<BaseRequestReader> readers;
+        if (requests_text) {
+            const size_t request_count = requests_text->size();
+            const size_t part_count = std::max<size_t>(
+                1, std::min(request_count, parallel::GetThreadPool().GetThreadCount() * 4));
+            for (size_t part = 0; part < part_count; ++part) {
+                readers.emplace_back(input, 1);
+            }
+            std::vector<char> parts_whole(part_count, true);
+            parallel::ParallelFor(part_count, [&](size_t begin, size_t end) {
+                for (size_t part = begin; part < end; ++part) {
+                    for (size_t i = request_count * part / part_count; i < request_count * (part + 1) / part_count; ++i) {
+                        if (!json::ParseWhole((*requests_text)[i], readers[part])) {
+                            parts_whole[part] = false;
+                            break;
+                        }
+                    }
+                }
+            });
+            if (std::find(parts_whole.begin(), parts_whole.end(), false) != parts_whole.end()) {
+                return ReadInputSequential(input, catalogue);
+            }
+        }
+
+        // Остальные разделы разбираются до заполнения каталога, чтобы ошибка
+        // в них, как и при последовательном разборе, обнаружилась раньше
+        json::FlatBuilder builder(input);
+        builder.StartObject();
+        for (const json::MemberSpan& member : *members) {
+            if (member.key != "base_requests"sv) {
+                builder.Key(member.key);
+                if (!json::ParseWhole(member.value, builder)) {
+                    return ReadInputSequential(input, catalogue);
+                }
+            }
+        }
+        builder.EndObject();
+
+        std::vector<BaseRequest> requests;
+        for (BaseRequestReader& reader : readers) {
+            auto& part_requests = reader.GetRequests();
+            std::move(part_requests.begin(), part_requests.end(), std::back_inserter(requests));
+        }
+        FillCatalogue(requests, catalogue);
+        return builder.Extract();
+    }
+
+}  // namespace
+
+JsonReader::JsonReader(std::istream& input, transport_catalogue::TransportCatalogue& catalogue)
+    : input_buffer_(json::ReadAll(input))
+    , input_(ReadInput(input_buffer_, catalogue))
+{
 }
 
-const json::Node& JsonReader::GetStatRequests() const {
+const json::FlatNode& JsonReader::GetStatRequests() const {
 
     const auto& root = input_.GetRoot().AsDict();
 
@@ -36,7 +559,7 @@ const json::Node& JsonReader::GetStatRequests() const {
     return dummy_;
 }
 
-const json::Node& JsonReader::GetRenderSettings() const {
+const json::FlatNode& JsonReader::GetRenderSettings() const {
 
     const auto& root = input_.GetRoot().AsDict();
 
@@ -50,7 +573,7 @@ const json::Node& JsonReader::GetRenderSettings() const {
     return dummy_;
 }
 
-const json::Node& JsonReader::GetRoutingSettings() const {
+const json::FlatNode& JsonReader::GetRoutingSettings() const {
     
     const auto& root = input_.GetRoot().AsDict();
 
@@ -64,103 +587,93 @@ const json::Node& JsonReader::GetRoutingSettings() const {
     return dummy_;
 }
 
-void JsonReader::ProcessRequests(const json::Node& stat_requests, RequestHandler& rh) const {
-    json::Array result;
-    for (auto& request : stat_requests.AsArray()) {
-        const auto& request_map = request.AsDict();
-        const auto& type = request_map.at("type").AsString();
-
-        if (type == "Stop") {
-            result.push_back(PrintStop(request_map, rh).AsDict());
-        }
-        else if (type == "Bus") {
-            result.push_back(PrintRoute(request_map, rh).AsDict());
-        }
-        else if (type == "Map") {
-            result.push_back(PrintMap(request_map, rh).AsDict());
-        }
-        else if (type == "Route") {
-            result.push_back(PrintRouting(request_map, rh).AsDict());
-        }
-    }
-
-    json::Print(json::Document{ result }, std::cout);
-}
-
-void JsonReader::FillCatalogueStop(const json::Array& stops_array, transport_catalogue::TransportCatalogue& catalogue) {
-    for (auto& request_stops : stops_array) {
-        const auto& request_stops_map = request_stops.AsDict();
-        const auto& type = request_stops_map.at("type").AsString();
-        if (type == "Stop") {
-            auto [stop_name, coordinates, stop_distances] = FillStop(request_stops_map);
-            catalogue.AddStop(stop_name, coordinates);
-        }
-    }
-    FillStopDistances(catalogue);
+void JsonReader::ProcessRequests(const json::FlatNode& stat_requests, RequestHandler& rh) const {
+    // Запросы выполняются в пуле, а ответы печатаются в исходном порядке по мере
+    // готовности, не накапливаясь в одном массиве
+    const json::FlatArray requests = stat_requests.AsArray();
+    json::ArrayWriter writer(std::cout);
+    ForEachResponse(requests, rh, [&writer](const json::Node& response) {
+        writer.Write(response);
+    });
+    writer.Finish();
 }
 
-void JsonReader::FillCatalogueBus(const json::Array& buses_array, transport_catalogue::TransportCatalogue& catalogue) {
-    for (auto& request_bus : buses_array) {
-        const auto& request_bus_map = request_bus.AsDict();
-        const auto& type = request_bus_map.at("type").AsString();
-        if (type == "Bus") {
-            auto [bus_number, stops, circular_route] = FillRoute(request_bus_map, catalogue);
-            catalogue.AddRoute(bus_number, stops, circular_route);
-        }
-    }
+void JsonReader::ForEachResponse(const json::FlatArray& requests, RequestHandler& rh,
+    const std::function<void(const json::Node&)>& output) const {
+    // Запросы только читают каталог, маршрутизатор и настройки отрисовки
+    const size_t window = parallel::GetThreadPool().GetThreadCount() * RESPONSES_IN_FLIGHT_PER_THREAD;
+    parallel::ParallelForOrdered(requests.size(), window,
+        [this, &requests, &rh](size_t index) {
+            return ProcessRequest(requests[index].AsDict(), rh);
+        },
+        [&output](size_t, std::optional<json::Node> response) {
+            if (response) {
+                output(*response);
+            }
+        });
 }
 
-void JsonReader::FillCatalogue(transport_catalogue::TransportCatalogue& catalogue) {
-    const json::Array& arr = GetBaseRequests().AsArray();
-
-    FillCatalogueStop(arr, catalogue);
-    FillCatalogueBus(arr, catalogue);
-}
+std::optional<json::Node> JsonReader::ProcessRequest(const json::FlatDict& request_map, RequestHandler& rh) const {
+    const auto& type = request_map.at("type").AsString();
 
-std::tuple<std::string_view, geo::Coordinates, std::map<std::string_view, int>> JsonReader::FillStop(const json::Dict& request_map) const {
-    std::string_view stop_name = request_map.at("name").AsString();
-    geo::Coordinates coordinates = { request_map.at("latitude").AsDouble(), request_map.at("longitude").AsDouble() };
-    std::map<std::string_view, int> stop_distances;
-    auto& distances = request_map.at("road_distances").AsDict();
-    for (auto& [stop_name, dist] : distances) {
-        stop_distances.emplace(stop_name, dist.AsInt());
+    if (type == "Stop") {
+        return PrintStop(request_map, rh);
+    }
+    else if (type == "Bus") {
+        return PrintRoute(request_map, rh);
     }
-    return { stop_name, coordinates, stop_distances };
+    else if (type == "Map") {
+        return PrintMap(request_map, rh);
+    }
+    else if (type == "Route") {
+        return PrintRouting(request_map, rh);
+    }
+    return std::nullopt;
 }
 
-void JsonReader::FillStopDistances(transport_catalogue::TransportCatalogue& catalogue) const {
-    const json::Array& arr = GetBaseRequests().AsArray();
-    for (auto& request_stops : arr) {
-        const auto& request_stops_map = request_stops.AsDict();
-        const auto& type = request_stops_map.at("type").AsString();
-        if (type == "Stop") {
-            auto [stop_name, coordinates, stop_distances] = FillStop(request_stops_map);
-            for (auto& [to_name, dist] : stop_distances) {
-                auto from = catalogue.FindStop(stop_name);
-                auto to = catalogue.FindStop(to_name);
-                catalogue.SetDistance(from, to, dist);
-            }
+std::string JsonReader::ProcessRequestLine(std::string_view line, RequestHandler& rh) const {
+    std::string result;
+    try {
+        const json::FlatDocument request = json::LoadFlat(line);
+        const json::FlatNode& root = request.GetRoot();
+        if (root.IsArray()) {
+            result += '[';
+            ForEachResponse(root.AsArray(), rh, [&result](const json::Node& response) {
+                if (result.size() > 1) {
+                    result += ',';
+                }
+                json::Print(json::Document{ response }, result, json::PrintMode::COMPACT);
+            });
+            result += ']';
+            return result;
         }
-    }
-}
 
-std::tuple<std::string_view, std::vector<const transport_catalogue::Stop*>, bool> JsonReader::FillRoute(const json::Dict& request_map, transport_catalogue::TransportCatalogue& catalogue) const {
-    std::string_view bus_number = request_map.at("name").AsString();
-    std::vector<const transport_catalogue::Stop*> stops;
-    for (auto& stop : request_map.at("stops").AsArray()) {
-        stops.push_back(catalogue.FindStop(stop.AsString()));
+        const auto response = ProcessRequest(root.AsDict(), rh);
+        if (!response) {
+            throw std::logic_error("Unknown request type");
+        }
+        json::Print(json::Document{ *response }, result, json::PrintMode::COMPACT);
+        return result;
+    }
+    catch (const std::exception& e) {
+        // Ошибка в запросе не должна останавливать сервер: клиент получает её текст
+        result.clear();
+        const json::Node error = json::Builder{}
+            .StartDict()
+            .Key("error_message"s).Value(std::string(e.what()))
+            .EndDict()
+            .Build();
+        json::Print(json::Document{ error }, result, json::PrintMode::COMPACT);
+        return result;
     }
-    bool circular_route = request_map.at("is_roundtrip").AsBool();
-
-    return { bus_number, stops, circular_route };
 }
 
-svg::Color JsonReader::ParseColor(const json::Node& colorNode) const {
+svg::Color JsonReader::ParseColor(const json::FlatNode& colorNode) const {
     if (colorNode.IsString()) {
-        return colorNode.AsString();
+        return std::string(colorNode.AsString());
     }
     else if (colorNode.IsArray()) {
-        const json::Array& colorArray = colorNode.AsArray();
+        const json::FlatArray colorArray = colorNode.AsArray();
         if (colorArray.size() == ColorTypeRGB::TipeRgb) {
             return svg::Rgb(colorArray[0].AsInt(), colorArray[1].AsInt(), colorArray[2].AsInt());
         }
@@ -176,7 +689,7 @@ svg::Color JsonReader::ParseColor(const json::Node& colorNode) const {
     }
 }
 
-renderer::MapRenderer JsonReader::FillRenderSettings(const json::Dict& request_map) const {
+renderer::MapRenderer JsonReader::FillRenderSettings(const json::FlatDict& request_map) const {
     renderer::RenderSettings render_settings;
     render_settings.width = request_map.at("width").AsDouble();
     render_settings.height = request_map.at("height").AsDouble();
@@ -184,17 +697,17 @@ renderer::MapRenderer JsonReader::FillRenderSettings(const json::Dict& request_m
     render_settings.stop_radius = request_map.at("stop_radius").AsDouble();
     render_settings.line_width = request_map.at("line_width").AsDouble();
     render_settings.bus_label_font_size = request_map.at("bus_label_font_size").AsInt();
-    const json::Array& bus_label_offset = request_map.at("bus_label_offset").AsArray();
+    const json::FlatArray bus_label_offset = request_map.at("bus_label_offset").AsArray();
     render_settings.bus_label_offset = { bus_label_offset[0].AsDouble(), bus_label_offset[1].AsDouble() };
     render_settings.stop_label_font_size = request_map.at("stop_label_font_size").AsInt();
-    const json::Array& stop_label_offset = request_map.at("stop_label_offset").AsArray();
+    const json::FlatArray stop_label_offset = request_map.at("stop_label_offset").AsArray();
     render_settings.stop_label_offset = { stop_label_offset[0].AsDouble(), stop_label_offset[1].AsDouble() };
 
     render_settings.underlayer_color = ParseColor(request_map.at("underlayer_color"));
 
     render_settings.underlayer_width = request_map.at("underlayer_width").AsDouble();
 
-    const json::Array& color_palette = request_map.at("color_palette").AsArray();
+    const json::FlatArray color_palette = request_map.at("color_palette").AsArray();
     for (const auto& color_element : color_palette) {
         render_settings.color_palette.push_back(ParseColor(color_element));
     }
@@ -202,41 +715,87 @@ renderer::MapRenderer JsonReader::FillRenderSettings(const json::Dict& request_m
     return render_settings;
 }
 
-transport_catalogue::Router JsonReader::FillRoutingSettings(const json::Node& settings) const {
+transport_catalogue::Router JsonReader::FillRoutingSettings(const json::FlatNode& settings) const {
+    const auto& settings_map = settings.AsDict();
+    transport_catalogue::RouterType router_type = transport_catalogue::RouterType::ALL_PAIRS;
+
+    if (auto it = settings_map.find("router_type"); it != settings_map.end()) {
+        const std::string_view type = it->second.AsString();
+        if (type == "dijkstra") {
+            router_type = transport_catalogue::RouterType::DIJKSTRA;
+        }
+        else if (type == "contraction_hierarchy") {
+            router_type = transport_catalogue::RouterType::CONTRACTION_HIERARCHY;
+        }
+        else if (type != "all_pairs") {
+            throw std::logic_error("Invalid router type");
+        }
+    }
+
+    transport_catalogue::GraphModel graph_model = transport_catalogue::GraphModel::STOP_PAIRS;
+    if (auto it = settings_map.find("graph_model"); it != settings_map.end()) {
+        const std::string_view model = it->second.AsString();
+        if (model == "route_nodes") {
+            graph_model = transport_catalogue::GraphModel::ROUTE_NODES;
+        }
+        else if (model != "stop_pairs") {
+            throw std::logic_error("Invalid graph model");
+        }
+    }
+
+    // Кэш деревьев кратчайших путей есть только у маршрутизатора dijkstra
+    size_t tree_cache_budget = 0;
+    if (auto it = settings_map.find("route_cache_mb"); it != settings_map.end()) {
+        if (router_type != transport_catalogue::RouterType::DIJKSTRA) {
+            throw std::logic_error("route_cache_mb is supported only by the dijkstra router");
+        }
+        const int cache_mb = it->second.AsInt();
+        if (cache_mb < 0) {
+            throw std::logic_error("route_cache_mb must not be negative");
+        }
+        tree_cache_budget = static_cast<size_t>(cache_mb) * 1024 * 1024;
+    }
+
     return {
-        settings.AsDict().at("bus_wait_time").AsInt(),
-        settings.AsDict().at("bus_velocity").AsDouble()
+        settings_map.at("bus_wait_time").AsInt(),
+        settings_map.at("bus_velocity").AsDouble(),
+        router_type,
+        tree_cache_budget,
+        graph_model
     };
 }
 
-const json::Node JsonReader::PrintRoute(const json::Dict& request_map, RequestHandler& rh) const {
+const json::Node JsonReader::PrintRoute(const json::FlatDict& request_map, RequestHandler& rh) const {
     json::Dict result;
-    const std::string& route_number = request_map.at("name").AsString();
+    const std::string_view route_number = request_map.at("name").AsString();
     result["request_id"] = request_map.at("id").AsInt();
-    if (!rh.IsBusNumber(route_number)) {
+    const transport_catalogue::Bus* bus = rh.FindBus(route_number);
+    if (!bus) {
         result["error_message"] = json::Node{ static_cast<std::string>("not found") };
     }
     else {
-        result["curvature"] = rh.RouteInformation(route_number)->curvature;
-        result["route_length"] = rh.RouteInformation(route_number)->route_length;
-        result["stop_count"] = static_cast<int>(rh.RouteInformation(route_number)->stops_count);
-        result["unique_stop_count"] = static_cast<int>(rh.RouteInformation(route_number)->unique_stops_count);
+        const transport_catalogue::BusStat bus_stat = rh.RouteInformation(bus->id);
+        result["curvature"] = bus_stat.curvature;
+        result["route_length"] = bus_stat.route_length;
+        result["stop_count"] = static_cast<int>(bus_stat.stops_count);
+        result["unique_stop_count"] = static_cast<int>(bus_stat.unique_stops_count);
     }
 
     return json::Node{ result };
 }
 
-const json::Node JsonReader::PrintStop(const json::Dict& request_map, RequestHandler& rh) const {
+const json::Node JsonReader::PrintStop(const json::FlatDict& request_map, RequestHandler& rh) const {
     json::Dict result;
-    const std::string& stop_name = request_map.at("name").AsString();
+    const std::string_view stop_name = request_map.at("name").AsString();
     result["request_id"] = request_map.at("id").AsInt();
-    if (!rh.IsStopName(stop_name)) {
+    const transport_catalogue::Stop* stop = rh.FindStop(stop_name);
+    if (!stop) {
         result["error_message"] = json::Node{ static_cast<std::string>("not found") };
     }
     else {
         json::Array buses;
-        for (auto& bus : rh.GetBusesByStop(stop_name)) {
-            buses.push_back(bus);
+        for (const auto bus : rh.GetBusesByStop(stop->id)) {
+            buses.emplace_back(std::string(bus));
         }
         result["buses"] = buses;
     }
@@ -244,23 +803,51 @@ const json::Node JsonReader::PrintStop(const json::Dict& request_map, RequestHan
     return json::Node{ result };
 }
 
-const json::Node JsonReader::PrintMap(const json::Dict& request_map, RequestHandler& rh) const {
+std::optional<renderer::Rect> JsonReader::ParseViewport(const json::FlatDict& request_map, RequestHandler& rh) const {
+    if (const auto it = request_map.find("tile"); it != request_map.end()) {
+        const json::FlatDict tile = it->second.AsDict();
+        return rh.GetTileViewport(tile.at("z"s).AsInt(), tile.at("x"s).AsInt(), tile.at("y"s).AsInt());
+    }
+
+    const json::FlatArray bbox = request_map.at("bbox"s).AsArray();
+    if (bbox.size() != 4) {
+        return std::nullopt;
+    }
+    const renderer::Rect viewport{ bbox[0].AsDouble(), bbox[1].AsDouble(), bbox[2].AsDouble(), bbox[3].AsDouble() };
+    if (!(viewport.min_x < viewport.max_x && viewport.min_y < viewport.max_y)) {
+        return std::nullopt;
+    }
+    return viewport;
+}
+
+const json::Node JsonReader::PrintMap(const json::FlatDict& request_map, RequestHandler& rh) const {
     json::Dict result;
     result["request_id"] = request_map.at("id").AsInt();
-    std::ostringstream strm;
-    svg::Document map = rh.RenderMap();
-    map.Render(strm);
-    result["map"] = strm.str();
+    if (request_map.count("bbox"s) > 0 || request_map.count("tile"s) > 0) {
+        // Фрагменты не кешируются: их много, и каждый строится только из видимых объектов
+        const auto viewport = ParseViewport(request_map, rh);
+        if (!viewport) {
+            result["error_message"] = json::Node{ "invalid viewport"s };
+            return json::Node{ result };
+        }
+        result["map"] = rh.RenderMapFragment(*viewport);
+        return json::Node{ result };
+    }
+    // Готовый литерал разделяется со всеми ответами на Map до изменения каталога
+    const auto map = rh.GetRenderedMap();
+    result["map"] = json::RawJson{ std::shared_ptr<const std::string>(map, &map->json_literal) };
 
     return json::Node{ result };
 }
 
-const json::Node JsonReader::PrintRouting(const json::Dict& request_map, RequestHandler& rh) const {
+const json::Node JsonReader::PrintRouting(const json::FlatDict& request_map, RequestHandler& rh) const {
     json::Node result;
     const int id = request_map.at("id"s).AsInt();
-    const std::string_view stop_from = request_map.at("from"s).AsString();
-    const std::string_view stop_to = request_map.at("to"s).AsString();
-    const auto& routing = rh.GetOptimalRoute(stop_from, stop_to);
+    const transport_catalogue::Stop* stop_from = rh.FindStop(request_map.at("from"s).AsString());
+    const transport_catalogue::Stop* stop_to = rh.FindStop(request_map.at("to"s).AsString());
+    const auto& routing = stop_from && stop_to
+        ? rh.GetOptimalRoute(stop_from->id, stop_to->id)
+        : std::nullopt;
 
     if (!routing) {
         result = json::Builder{}
@@ -272,39 +859,33 @@ const json::Node JsonReader::PrintRouting(const json::Dict& request_map, Request
     }
     else {
         json::Array items;
-        double total_time = 0.0;
-        items.reserve(routing.value().edges.size());
-        for (auto& edge_id : routing.value().edges) {
-            const graph::Edge<double> edge = rh.GetRouterGraph().GetEdge(edge_id);
-            if (edge.quality == 0) {
+        items.reserve(routing->items.size());
+        for (const auto& item : routing->items) {
+            if (item.span_count == 0) {
                 items.emplace_back(json::Node(json::Builder{}
                     .StartDict()
-                    .Key("stop_name"s).Value(edge.name)
-                    .Key("time"s).Value(edge.weight)
+                    .Key("stop_name"s).Value(std::string(item.name))
+                    .Key("time"s).Value(item.time)
                     .Key("type"s).Value("Wait"s)
                     .EndDict()
                     .Build()));
-
-                total_time += edge.weight;
             }
             else {
                 items.emplace_back(json::Node(json::Builder{}
                     .StartDict()
-                    .Key("bus"s).Value(edge.name)
-                    .Key("span_count"s).Value(static_cast<int>(edge.quality))
-                    .Key("time"s).Value(edge.weight)
+                    .Key("bus"s).Value(std::string(item.name))
+                    .Key("span_count"s).Value(static_cast<int>(item.span_count))
+                    .Key("time"s).Value(item.time)
                     .Key("type"s).Value("Bus"s)
                     .EndDict()
                     .Build()));
-
-                total_time += edge.weight;
             }
         }
 
         result = json::Builder{}
             .StartDict()
             .Key("request_id"s).Value(id)
-            .Key("total_time"s).Value(total_time)
+            .Key("total_time"s).Value(routing->total_time)
             .Key("items"s).Value(items)
             .EndDict()
             .Build();
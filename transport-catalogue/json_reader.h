@@ -1,45 +1,56 @@
 #pragma once
 
 #include "json.h"
+#include "json_flat.h"
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "request_handler.h"
 
+#include <functional>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
 
 class JsonReader {
 public:
-    JsonReader(std::istream& input)
-        : input_(json::Load(input))
-    {
-    }
-
-    const json::Node& GetBaseRequests() const;
-    const json::Node& GetStatRequests() const;
-    const json::Node& GetRenderSettings() const;
-    const json::Node& GetRoutingSettings() const;
-
-    void ProcessRequests(const json::Node& stat_requests, RequestHandler& rh) const;
-
-    void FillCatalogueStop(const json::Array& stops_array, transport_catalogue::TransportCatalogue& catalogue);
-    void FillCatalogueBus(const json::Array& buses_array, transport_catalogue::TransportCatalogue& catalogue);
-
-    void FillCatalogue(transport_catalogue::TransportCatalogue& catalogue);
-    renderer::MapRenderer FillRenderSettings(const json::Dict& request_map) const;
-    transport_catalogue::Router FillRoutingSettings(const json::Node& settings) const;
-
-    svg::Color ParseColor(const json::Node& colorNode) const;
-
-    const json::Node PrintRoute(const json::Dict& request_map, RequestHandler& rh) const;
-    const json::Node PrintStop(const json::Dict& request_map, RequestHandler& rh) const;
-    const json::Node PrintMap(const json::Dict& request_map, RequestHandler& rh) const;
-    const json::Node PrintRouting(const json::Dict& request_map, RequestHandler& rh) const;
+    // Запросы base_requests разбираются потоково и сразу заполняют catalogue,
+    // в памяти остаются только остальные разделы, размещённые в арене
+    JsonReader(std::istream& input, transport_catalogue::TransportCatalogue& catalogue);
+
+    const json::FlatNode& GetStatRequests() const;
+    const json::FlatNode& GetRenderSettings() const;
+    const json::FlatNode& GetRoutingSettings() const;
+
+    void ProcessRequests(const json::FlatNode& stat_requests, RequestHandler& rh) const;
+    // Ответ на один запрос; запросы неизвестного типа пропускаются
+    std::optional<json::Node> ProcessRequest(const json::FlatDict& request_map, RequestHandler& rh) const;
+    // Строка запросов в режиме сервера: массив запросов либо один запрос.
+    // Ответ - компактный JSON в одну строку, ошибка возвращается как
+    // {"error_message": ...}
+    std::string ProcessRequestLine(std::string_view line, RequestHandler& rh) const;
+
+    renderer::MapRenderer FillRenderSettings(const json::FlatDict& request_map) const;
+    transport_catalogue::Router FillRoutingSettings(const json::FlatNode& settings) const;
+
+    svg::Color ParseColor(const json::FlatNode& colorNode) const;
+    // Область запроса Map: "bbox": [min_x, min_y, max_x, max_y] в координатах
+    // полной карты либо "tile": {"z", "x", "y"}. nullopt для пустой области
+    // и несуществующей плитки
+    std::optional<renderer::Rect> ParseViewport(const json::FlatDict& request_map, RequestHandler& rh) const;
+
+    const json::Node PrintRoute(const json::FlatDict& request_map, RequestHandler& rh) const;
+    const json::Node PrintStop(const json::FlatDict& request_map, RequestHandler& rh) const;
+    const json::Node PrintMap(const json::FlatDict& request_map, RequestHandler& rh) const;
+    const json::Node PrintRouting(const json::FlatDict& request_map, RequestHandler& rh) const;
 
 private:
-    json::Document input_;
-    json::Node dummy_ = nullptr;
-
-    std::tuple<std::string_view, geo::Coordinates, std::map<std::string_view, int>> FillStop(const json::Dict& request_map) const;
-    void FillStopDistances(transport_catalogue::TransportCatalogue& catalogue) const;
-    std::tuple<std::string_view, std::vector<const transport_catalogue::Stop*>, bool> FillRoute(const json::Dict& request_map, transport_catalogue::TransportCatalogue& catalogue) const;
+    // Выполняет запросы параллельно и передаёт ответы в output в порядке запросов
+    void ForEachResponse(const json::FlatArray& requests, RequestHandler& rh,
+        const std::function<void(const json::Node&)>& output) const;
+
+    // Входной текст; строки input_ без экранирования ссылаются прямо на него
+    std::string input_buffer_;
+    json::FlatDocument input_;
+    json::FlatNode dummy_;
 };
\ No newline at end of file
@@ -0,0 +1,303 @@
+#include "json_structural_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define JSON_SIMD_X86 1
+#define JSON_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#include <immintrin.h>
+#define JSON_SIMD_X86 1
+#define JSON_TARGET_AVX2
+#endif
+
+namespace json {
+
+    namespace {
+
+        // Маски одного 64-байтного блока: бит i соответствует байту i
+        struct BlockMasks {
+            uint64_t quote = 0;
+            uint64_t backslash = 0;
+            uint64_t op = 0;
+            uint64_t whitespace = 0;
+        };
+
+        bool IsOp(char c) {
+            return c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',';
+        }
+
+        // Тот же набор, что и у разборщика
+        bool IsWhitespace(char c) {
+            return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+        }
+
+        int CountTrailingZeros(uint64_t value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long index;
+            _BitScanForward64(&index, value);
+            return static_cast<int>(index);
+#else
+            return __builtin_ctzll(value);
+#endif
+        }
+
+        void ClassifyScalar(const char* block, BlockMasks& masks) {
+            for (int i = 0; i < 64; ++i) {
+                const uint64_t bit = uint64_t{ 1 } << i;
+                const char c = block[i];
+                if (c == '"') {
+                    masks.quote |= bit;
+                }
+                else if (c == '\\') {
+                    masks.backslash |= bit;
+                }
+                else if (IsOp(c)) {
+                    masks.op |= bit;
+                }
+                else if (IsWhitespace(c)) {
+                    masks.whitespace |= bit;
+                }
+            }
+        }
+
+        const char* FindStringSpecialScalar(const char* pos, const char* end) {
+            while (pos != end && *pos != '"' && *pos != '\\' && *pos != '\n' && *pos != '\r') {
+                ++pos;
+            }
+            return pos;
+        }
+
+#ifdef JSON_SIMD_X86
+        uint64_t Movemask16(__m128i mask) {
+            return static_cast<uint16_t>(_mm_movemask_epi8(mask));
+        }
+
+        void ClassifySse2(const char* block, BlockMasks& masks) {
+            for (int part = 0; part < 4; ++part) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + part * 16));
+                auto eq = [&v](char c) {
+                    return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+                };
+                const __m128i op = _mm_or_si128(
+                    _mm_or_si128(_mm_or_si128(eq('{'), eq('}')), _mm_or_si128(eq('['), eq(']'))),
+                    _mm_or_si128(eq(':'), eq(',')));
+                // \t \n \v \f \r идут подряд: 9..13
+                const __m128i control_space = _mm_and_si128(
+                    _mm_cmpgt_epi8(v, _mm_set1_epi8(8)), _mm_cmplt_epi8(v, _mm_set1_epi8(14)));
+                const __m128i whitespace = _mm_or_si128(eq(' '), control_space);
+
+                const int shift = part * 16;
+                masks.quote |= Movemask16(eq('"')) << shift;
+                masks.backslash |= Movemask16(eq('\\')) << shift;
+                masks.op |= Movemask16(op) << shift;
+                masks.whitespace |= Movemask16(whitespace) << shift;
+            }
+        }
+
+        const char* FindStringSpecialSse2(const char* pos, const char* end) {
+            while (end - pos >= 16) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+                const __m128i special = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+                    _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+                if (const int mask = _mm_movemask_epi8(special); mask != 0) {
+                    return pos + CountTrailingZeros(static_cast<unsigned>(mask));
+                }
+                pos += 16;
+            }
+            return FindStringSpecialScalar(pos, end);
+        }
+
+        JSON_TARGET_AVX2 uint64_t Movemask32(__m256i mask) {
+            return static_cast<uint32_t>(_mm256_movemask_epi8(mask));
+        }
+
+        JSON_TARGET_AVX2 void ClassifyAvx2(const char* block, BlockMasks& masks) {
+            for (int part = 0; part < 2; ++part) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + part * 32));
+                const __m256i open_curly = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('{'));
+                const __m256i close_curly = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('}'));
+                const __m256i open_square = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('['));
+                const __m256i close_square = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(']'));
+                const __m256i colon = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(':'));
+                const __m256i comma = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','));
+                const __m256i op = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_or_si256(open_curly, close_curly), _mm256_or_si256(open_square, close_square)),
+                    _mm256_or_si256(colon, comma));
+                const __m256i control_space = _mm256_and_si256(
+                    _mm256_cmpgt_epi8(v, _mm256_set1_epi8(8)), _mm256_cmpgt_epi8(_mm256_set1_epi8(14), v));
+                const __m256i whitespace = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), control_space);
+
+                const int shift = part * 32;
+                masks.quote |= Movemask32(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))) << shift;
+                masks.backslash |= Movemask32(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))) << shift;
+                masks.op |= Movemask32(op) << shift;
+                masks.whitespace |= Movemask32(whitespace) << shift;
+            }
+        }
+
+        JSON_TARGET_AVX2 const char* FindStringSpecialAvx2(const char* pos, const char* end) {
+            while (end - pos >= 32) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+                const __m256i special = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+                if (const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(special)); mask != 0) {
+                    return pos + CountTrailingZeros(mask);
+                }
+                pos += 32;
+            }
+            return FindStringSpecialSse2(pos, end);
+        }
+
+        bool HasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) {
+                return false;
+            }
+            __cpuidex(info, 7, 0);
+            const bool avx2 = (info[1] & (1 << 5)) != 0;
+            __cpuid(info, 1);
+            // Регистры ymm должны сохраняться операционной системой
+            const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+            return avx2 && os_saves_ymm;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+
+        using Classifier = void (*)(const char*, BlockMasks&);
+        using StringScanner = const char* (*)(const char*, const char*);
+
+        struct Kernels {
+            SimdLevel level = SimdLevel::SCALAR;
+            Classifier classify = ClassifyScalar;
+            StringScanner find_string_special = FindStringSpecialScalar;
+        };
+
+        // Набор функций уровня level; уровень должен поддерживаться процессором
+        Kernels MakeKernels(SimdLevel level) {
+#ifdef JSON_SIMD_X86
+            if (level == SimdLevel::AVX2) {
+                return { SimdLevel::AVX2, ClassifyAvx2, FindStringSpecialAvx2 };
+            }
+            if (level == SimdLevel::SSE2) {
+                return { SimdLevel::SSE2, ClassifySse2, FindStringSpecialSse2 };
+            }
+#endif
+            return {};
+        }
+
+        const Kernels& GetKernels() {
+            static const Kernels kernels = [] {
+#ifdef JSON_SIMD_X86
+                return MakeKernels(HasAvx2() ? SimdLevel::AVX2 : SimdLevel::SSE2);
+#else
+                return MakeKernels(SimdLevel::SCALAR);
+#endif
+            }();
+            return kernels;
+        }
+
+        // Префиксный xor: бит i результата - xor битов 0..i
+        uint64_t PrefixXor(uint64_t bits) {
+            bits ^= bits << 1;
+            bits ^= bits << 2;
+            bits ^= bits << 4;
+            bits ^= bits << 8;
+            bits ^= bits << 16;
+            bits ^= bits << 32;
+            return bits;
+        }
+
+        // Маска символов, экранированных обратным слешем. Серия слешей нечётной
+        // длины экранирует следующий за ней символ; prev_escaped - экранирован ли
+        // первый символ блока слешем из конца предыдущего
+        uint64_t FindEscaped(uint64_t backslash, uint64_t& prev_escaped) {
+            constexpr uint64_t EVEN_BITS = 0x5555555555555555ULL;
+
+            backslash &= ~prev_escaped;
+            const uint64_t follows_escape = backslash << 1 | prev_escaped;
+            const uint64_t odd_sequence_starts = backslash & ~EVEN_BITS & ~follows_escape;
+
+            const uint64_t sequences_starting_on_even_bits = odd_sequence_starts + backslash;
+            prev_escaped = sequences_starting_on_even_bits < odd_sequence_starts ? 1 : 0;
+
+            const uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+            return (EVEN_BITS ^ invert_mask) & follows_escape;
+        }
+
+    }  // namespace
+
+    SimdLevel GetSimdLevel() {
+        return GetKernels().level;
+    }
+
+    StructuralIndex::StructuralIndex(std::string_view input)
+        : StructuralIndex(input, GetSimdLevel()) {
+    }
+
+    StructuralIndex::StructuralIndex(std::string_view input, SimdLevel level) {
+        const Kernels kernels = MakeKernels(std::min(level, GetSimdLevel()));
+        // Позиции пишутся по указателю без проверок: перед каждым блоком
+        // гарантируется место под 64 лексемы
+        positions_.resize(input.size() / 4 + 64);
+        uint32_t* out = positions_.data();
+
+        uint64_t prev_escaped = 0;
+        uint64_t prev_in_string = 0;
+        uint64_t prev_scalar = 0;
+
+        char tail[64];
+        for (size_t offset = 0; offset < input.size(); offset += 64) {
+            const char* block = input.data() + offset;
+            if (input.size() - offset < 64) {
+                // Последний неполный блок дополняется пробелами
+                std::memset(tail, ' ', sizeof(tail));
+                std::memcpy(tail, block, input.size() - offset);
+                block = tail;
+            }
+            if (static_cast<size_t>(positions_.data() + positions_.size() - out) < 64) {
+                const size_t count = out - positions_.data();
+                positions_.resize(positions_.size() * 2);
+                out = positions_.data() + count;
+            }
+
+            BlockMasks masks;
+            kernels.classify(block, masks);
+
+            const uint64_t escaped = FindEscaped(masks.backslash, prev_escaped);
+            const uint64_t quote = masks.quote & ~escaped;
+            const uint64_t in_string = PrefixXor(quote) ^ prev_in_string;
+            prev_in_string = in_string >> 63 ? ~uint64_t{ 0 } : 0;
+            // Содержимое строк вместе с закрывающей кавычкой
+            const uint64_t string_tail = in_string ^ quote;
+
+            const uint64_t scalar = ~(masks.op | masks.whitespace);
+            const uint64_t nonquote_scalar = scalar & ~quote;
+            const uint64_t follows_nonquote_scalar = nonquote_scalar << 1 | prev_scalar;
+            prev_scalar = nonquote_scalar >> 63;
+
+            uint64_t structural = (masks.op | (scalar & ~follows_nonquote_scalar)) & ~string_tail;
+            const auto base = static_cast<uint32_t>(offset);
+            while (structural != 0) {
+                *out++ = base + CountTrailingZeros(structural);
+                structural &= structural - 1;
+            }
+        }
+        positions_.resize(out - positions_.data());
+    }
+
+    const char* FindStringSpecial(const char* pos, const char* end) {
+        return GetKernels().find_string_special(pos, end);
+    }
+
+}  // namespace json
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+    // Набор векторных инструкций, выбранный при первом обращении по
+    // возможностям процессора
+    enum class SimdLevel {
+        SCALAR,
+        SSE2,
+        AVX2
+    };
+
+    SimdLevel GetSimdLevel();
+
+    // Структурный индекс документа: отсортированные смещения всех лексем вне
+    // строк - символов {}[]:, открывающих кавычек и начал чисел и литералов.
+    // Строится блоками по 64 байта: маски кавычек, обратных слешей,
+    // структурных и пробельных символов считаются по 16-32 байта за инструкцию,
+    // а границы строк - через префиксный xor масок кавычек
+    class StructuralIndex {
+    public:
+        explicit StructuralIndex(std::string_view input);
+        // Индекс, построенный функциями заданного уровня, чтобы сравнивать их
+        // между собой. Уровень выше доступного процессору понижается до него
+        StructuralIndex(std::string_view input, SimdLevel level);
+
+        const std::vector<uint32_t>& GetPositions() const {
+            return positions_;
+        }
+
+    private:
+        std::vector<uint32_t> positions_;
+    };
+
+    // Первый из символов " \ \n \r в [pos, end), либо end
+    const char* FindStringSpecial(const char* pos, const char* end);
+
+}  // namespace json
\ No newline at end of file
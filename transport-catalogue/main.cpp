@@ -1,16 +1,38 @@
 #include "json_reader.h"
 #include "request_handler.h"
+#include "unix_socket_server.h"
 
-int main() {
-    transport_catalogue::TransportCatalogue catalogue;
-    JsonReader json_doc(std::cin);
+using namespace std::literals;
+
+// Без аргументов: разовый запуск, ответы на stat_requests печатаются в stdout.
+// С --serve <путь к сокету>: каталог, маршрутизатор и настройки отрисовки
+// строятся один раз, после чего запросы принимаются через Unix-сокет
+int main(int argc, char* argv[]) {
+    const char* socket_path = nullptr;
+    if (argc == 3 && argv[1] == "--serve"sv) {
+        socket_path = argv[2];
+    }
+    else if (argc != 1) {
+        std::cerr << "Usage: " << argv[0] << " [--serve <socket path>] < input.json"sv << std::endl;
+        return 1;
+    }
 
-    json_doc.FillCatalogue(catalogue);
+    transport_catalogue::TransportCatalogue catalogue;
+    JsonReader json_doc(std::cin, catalogue);
 
     const auto& stat_requests = json_doc.GetStatRequests();
-    const auto& render_settings = json_doc.GetRenderSettings().AsMap();
+    const auto& render_settings = json_doc.GetRenderSettings().AsDict();
     const auto& renderer = json_doc.FillRenderSettings(render_settings);
+    const transport_catalogue::Router router(json_doc.FillRoutingSettings(json_doc.GetRoutingSettings()), catalogue);
+
+    RequestHandler rh(catalogue, renderer, router);
+    if (!socket_path) {
+        json_doc.ProcessRequests(stat_requests, rh);
+        return 0;
+    }
 
-    RequestHandler rh(catalogue, renderer);
-    json_doc.ProcessRequests(stat_requests, rh);
+    server::UnixSocketServer server(socket_path, [&json_doc, &rh](std::string_view line) {
+        return json_doc.ProcessRequestLine(line, rh);
+    });
+    server.Run();
 }
\ No newline at end of file
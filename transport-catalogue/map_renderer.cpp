@@ -1,188 +1,446 @@
 #include "map_renderer.h"
+#include "thread_pool.h"
 
 namespace renderer {
 
-    bool IsZero(double value) {
-        return std::abs(value) < EPSILON;
-    }
+    namespace {
 
-    std::vector<svg::Polyline> MapRenderer::RenderRouteLines(const std::map<std::string_view, const transport_catalogue::Bus*>& buses, const SphereProjector& sp) const {
-        std::vector<svg::Polyline> result;
-        size_t color_num = 0;
-        for (const auto& [bus_number, bus] : buses) {
-            if (bus->stops.empty()) {
-                continue;
+        // Остановки в порядке проезда; некольцевой маршрут проходится и обратно
+        std::vector<const transport_catalogue::Stop*> GetRouteStops(const transport_catalogue::Bus& bus) {
+            std::vector<const transport_catalogue::Stop*> route_stops{ bus.stops.begin(), bus.stops.end() };
+            if (bus.is_circle == false) {
+                route_stops.insert(route_stops.end(), std::next(bus.stops.rbegin()), bus.stops.rend());
             }
+            return route_stops;
+        }
 
-            std::vector<const transport_catalogue::Stop*> route_stops{ bus->stops.begin(), bus->stops.end() };
-            if (bus->is_circle == false) {
-                route_stops.insert(route_stops.end(), std::next(bus->stops.rbegin()), bus->stops.rend());
-            }
+        Rect GetPointBox(svg::Point point) {
+            return { point.x, point.y, point.x, point.y };
+        }
 
-            svg::Polyline line;
-            for (const auto& stop : route_stops) {
-                line.AddPoint(sp(stop->coordinates));
+        // Отсечение отрезка прямоугольником (Лян - Барски). Возвращает
+        // параметры видимой части [t_begin, t_end] на отрезке from + t * (to - from)
+        std::optional<std::pair<double, double>> ClipSegment(svg::Point from, svg::Point to, const Rect& area) {
+            const double dx = to.x - from.x;
+            const double dy = to.y - from.y;
+            const double p[] = { -dx, dx, -dy, dy };
+            const double q[] = { from.x - area.min_x, area.max_x - from.x, from.y - area.min_y, area.max_y - from.y };
+
+            double t_begin = 0.0;
+            double t_end = 1.0;
+            for (int i = 0; i < 4; ++i) {
+                if (p[i] == 0.0) {
+                    if (q[i] < 0.0) {
+                        return std::nullopt;
+                    }
+                    continue;
+                }
+                const double t = q[i] / p[i];
+                if (p[i] < 0.0) {
+                    t_begin = std::max(t_begin, t);
+                }
+                else {
+                    t_end = std::min(t_end, t);
+                }
+            }
+            if (t_begin > t_end) {
+                return std::nullopt;
             }
-            line.SetStrokeColor(render_settings_.color_palette[color_num]);
-            line.SetFillColor("none");
-            line.SetStrokeWidth(render_settings_.line_width);
-            line.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-            line.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+            return std::pair{ t_begin, t_end };
+        }
 
-            if (color_num < (render_settings_.color_palette.size() - 1)) {
-                ++color_num;
+        // Концы отрезка остаются точными, чтобы соседние отрезки одного
+        // маршрута стыковались в одну ломаную
+        svg::Point GetSegmentPoint(svg::Point from, svg::Point to, double t) {
+            if (t == 0.0) {
+                return from;
             }
-            else {
-                color_num = 0;
+            if (t == 1.0) {
+                return to;
             }
-
-            result.push_back(line);
+            return { from.x + t * (to.x - from.x), from.y + t * (to.y - from.y) };
         }
 
-        return result;
+    }  // namespace
+
+    bool IsZero(double value) {
+        return std::abs(value) < EPSILON;
     }
 
-    std::vector<svg::Text> MapRenderer::GetBusLabel(const std::map<std::string_view, const transport_catalogue::Bus*>& buses, const SphereProjector& sp) const {
-        std::vector<svg::Text> result;
-        size_t color_num = 0;
-        for (const auto& [bus_number, bus] : buses) {
-            if (bus->stops.empty()) {
-                continue;
-            }
+    svg::Polyline MapRenderer::CreateRouteLine(size_t color_index) const {
+        svg::Polyline line;
+        line.SetStrokeColor(render_settings_.color_palette[color_index]);
+        line.SetFillColor("none");
+        line.SetStrokeWidth(render_settings_.line_width);
+        line.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
+        line.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+        return line;
+    }
 
-            svg::Text text;
-            svg::Text underlayer;
-            text.SetPosition(sp(bus->stops[0]->coordinates));
+    void MapRenderer::AddBusLabel(std::vector<svg::Text>& result, const transport_catalogue::Bus& bus, size_t color_index, svg::Point position) const {
+        svg::Text text;
+        svg::Text underlayer;
+        text.SetPosition(position);
 
-            text.SetOffset(render_settings_.bus_label_offset);
+        text.SetOffset(render_settings_.bus_label_offset);
 
-            text.SetFontSize(render_settings_.bus_label_font_size);
-            text.SetFontFamily("Verdana");
-            text.SetFontWeight("bold");
+        text.SetFontSize(render_settings_.bus_label_font_size);
+        text.SetFontFamily("Verdana");
+        text.SetFontWeight("bold");
 
-            text.SetData(bus->number);
+        text.SetData(std::string(bus.number));
 
-            text.SetFillColor(render_settings_.color_palette[color_num]);
-            if (color_num < (render_settings_.color_palette.size() - 1)) {
-                ++color_num;
-            }
-            else {
-                color_num = 0;
-            }
+        text.SetFillColor(render_settings_.color_palette[color_index]);
 
-            underlayer.SetPosition(sp(bus->stops[0]->coordinates));
+        underlayer.SetPosition(position);
 
-            underlayer.SetOffset(render_settings_.bus_label_offset);
+        underlayer.SetOffset(render_settings_.bus_label_offset);
 
-            underlayer.SetFontSize(render_settings_.bus_label_font_size);
-            underlayer.SetFontFamily("Verdana");
-            underlayer.SetFontWeight("bold");
+        underlayer.SetFontSize(render_settings_.bus_label_font_size);
+        underlayer.SetFontFamily("Verdana");
+        underlayer.SetFontWeight("bold");
 
-            underlayer.SetData(bus->number);
+        underlayer.SetData(std::string(bus.number));
 
-            underlayer.SetFillColor(render_settings_.underlayer_color);
-            underlayer.SetStrokeColor(render_settings_.underlayer_color);
-            underlayer.SetStrokeWidth(render_settings_.underlayer_width);
+        underlayer.SetFillColor(render_settings_.underlayer_color);
+        underlayer.SetStrokeColor(render_settings_.underlayer_color);
+        underlayer.SetStrokeWidth(render_settings_.underlayer_width);
 
-            underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-            underlayer.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+        underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
+        underlayer.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 
-            result.push_back(underlayer);
-            result.push_back(text);
+        result.push_back(std::move(underlayer));
+        result.push_back(std::move(text));
+    }
 
-            if (bus->is_circle == false && bus->stops[0] != bus->stops[bus->stops.size() - 1]) {
-                svg::Text text2{ text };
-                svg::Text underlayer2{ underlayer };
-                text2.SetPosition(sp(bus->stops[bus->stops.size() - 1]->coordinates));
-                underlayer2.SetPosition(sp(bus->stops[bus->stops.size() - 1]->coordinates));
+    svg::Circle MapRenderer::CreateStopSymbol(svg::Point position) const {
+        svg::Circle symbol;
+        symbol.SetCenter(position);
+        symbol.SetRadius(render_settings_.stop_radius);
+        symbol.SetFillColor("white");
+        return symbol;
+    }
 
-                result.push_back(underlayer2);
-                result.push_back(text2);
-            }
-        }
+    void MapRenderer::AddStopLabel(std::vector<svg::Text>& result, const transport_catalogue::Stop& stop, svg::Point position) const {
+        svg::Text text;
+        svg::Text underlayer;
+        text.SetPosition(position);
+        text.SetOffset(render_settings_.stop_label_offset);
+        text.SetFontSize(render_settings_.stop_label_font_size);
+        text.SetFontFamily("Verdana");
+        text.SetData(std::string(stop.name));
+        text.SetFillColor("black");
 
-        return result;
-    }
+        underlayer.SetPosition(position);
 
-    std::vector<svg::Circle> MapRenderer::GetStopsSymbols(const std::map<std::string_view, const transport_catalogue::Stop*>& stops, const SphereProjector& sp) const {
-        std::vector<svg::Circle> result;
-        for (const auto& [stop_name, stop] : stops) {
-            svg::Circle symbol;
-            symbol.SetCenter(sp(stop->coordinates));
-            symbol.SetRadius(render_settings_.stop_radius);
-            symbol.SetFillColor("white");
+        underlayer.SetOffset(render_settings_.stop_label_offset);
+
+        underlayer.SetFontSize(render_settings_.stop_label_font_size);
+        underlayer.SetFontFamily("Verdana");
+
+        underlayer.SetData(std::string(stop.name));
+
+        underlayer.SetFillColor(render_settings_.underlayer_color);
+
+        underlayer.SetStrokeColor(render_settings_.underlayer_color);
+        underlayer.SetStrokeWidth(render_settings_.underlayer_width);
+        underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
+        underlayer.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+
+        result.push_back(std::move(underlayer));
+        result.push_back(std::move(text));
+    }
 
-            result.push_back(symbol);
+    std::vector<svg::Polyline> MapRenderer::RenderRouteLines(const std::vector<ColoredBus>& buses, size_t begin, size_t end, const SphereProjector& sp) const {
+        std::vector<svg::Polyline> result;
+        result.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            svg::Polyline line = CreateRouteLine(buses[i].color_index);
+            for (const auto& stop : GetRouteStops(*buses[i].bus)) {
+                line.AddPoint(sp(stop->coordinates));
+            }
+            result.push_back(std::move(line));
         }
 
         return result;
     }
 
-    std::vector<svg::Text> MapRenderer::GetStopsLabels(const std::map<std::string_view, const transport_catalogue::Stop*>& stops, const SphereProjector& sp) const {
+    std::vector<svg::Text> MapRenderer::GetBusLabel(const std::vector<ColoredBus>& buses, size_t begin, size_t end, const SphereProjector& sp) const {
         std::vector<svg::Text> result;
-        svg::Text text;
-        svg::Text underlayer;
-        for (const auto& [stop_name, stop] : stops) {
-            text.SetPosition(sp(stop->coordinates));
-            text.SetOffset(render_settings_.stop_label_offset);
-            text.SetFontSize(render_settings_.stop_label_font_size);
-            text.SetFontFamily("Verdana");
-            text.SetData(stop->name);
-            text.SetFillColor("black");
-
-            underlayer.SetPosition(sp(stop->coordinates));
-
-            underlayer.SetOffset(render_settings_.stop_label_offset);
-
-            underlayer.SetFontSize(render_settings_.stop_label_font_size);
-            underlayer.SetFontFamily("Verdana");
+        result.reserve((end - begin) * 4);
+        for (size_t i = begin; i < end; ++i) {
+            const auto* bus = buses[i].bus;
+            AddBusLabel(result, *bus, buses[i].color_index, sp(bus->stops[0]->coordinates));
+            if (bus->is_circle == false && bus->stops[0] != bus->stops[bus->stops.size() - 1]) {
+                AddBusLabel(result, *bus, buses[i].color_index, sp(bus->stops[bus->stops.size() - 1]->coordinates));
+            }
+        }
 
-            underlayer.SetData(stop->name);
+        return result;
+    }
 
-            underlayer.SetFillColor(render_settings_.underlayer_color);
+    std::vector<svg::Circle> MapRenderer::GetStopsSymbols(const std::vector<const transport_catalogue::Stop*>& stops, size_t begin, size_t end, const SphereProjector& sp) const {
+        std::vector<svg::Circle> result;
+        result.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            result.push_back(CreateStopSymbol(sp(stops[i]->coordinates)));
+        }
 
-            underlayer.SetStrokeColor(render_settings_.underlayer_color);
-            underlayer.SetStrokeWidth(render_settings_.underlayer_width);
-            underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-            underlayer.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+        return result;
+    }
 
-            result.push_back(underlayer);
-            result.push_back(text);
+    std::vector<svg::Text> MapRenderer::GetStopsLabels(const std::vector<const transport_catalogue::Stop*>& stops, size_t begin, size_t end, const SphereProjector& sp) const {
+        std::vector<svg::Text> result;
+        result.reserve((end - begin) * 2);
+        for (size_t i = begin; i < end; ++i) {
+            AddStopLabel(result, *stops[i], sp(stops[i]->coordinates));
         }
 
         return result;
     }
 
-    svg::Document MapRenderer::GetSVG(const std::map<std::string_view, const transport_catalogue::Bus*>& buses) const {
-        svg::Document result;
+    MapRenderer::Layout MapRenderer::PrepareLayout(const std::map<std::string_view, const transport_catalogue::Bus*>& buses) const {
         std::vector<geo::Coordinates> route_stops_coord;
-        std::map<std::string_view, const transport_catalogue::Stop*> all_stops;
+        std::vector<const transport_catalogue::Stop*> all_stops;
+        std::vector<bool> is_stop_added;
+        std::vector<ColoredBus> colored_buses;
+        const size_t palette_size = render_settings_.color_palette.size();
 
         for (const auto& [bus_number, bus] : buses) {
             if (bus->stops.empty()) {
                 continue;
             }
+            colored_buses.push_back({ bus, palette_size > 0 ? colored_buses.size() % palette_size : 0 });
             for (const auto& stop : bus->stops) {
                 route_stops_coord.push_back(stop->coordinates);
-                all_stops[stop->name] = stop;
+                if (stop->id >= is_stop_added.size()) {
+                    is_stop_added.resize(stop->id + 1, false);
+                }
+                if (!is_stop_added[stop->id]) {
+                    is_stop_added[stop->id] = true;
+                    all_stops.push_back(stop);
+                }
             }
         }
+        std::sort(all_stops.begin(), all_stops.end(), [](const auto* lhs, const auto* rhs) {
+            return lhs->name < rhs->name;
+        });
         SphereProjector sp(route_stops_coord.begin(), route_stops_coord.end(), render_settings_.width, render_settings_.height, render_settings_.padding);
 
-        for (const auto& line : RenderRouteLines(buses, sp)) {
-            result.Add(line);
+        return { std::move(colored_buses), std::move(all_stops), sp };
+    }
+
+    svg::Document MapRenderer::GetSVG(const std::map<std::string_view, const transport_catalogue::Bus*>& buses) const {
+        const Layout layout = PrepareLayout(buses);
+        const auto& colored_buses = layout.buses;
+        const auto& all_stops = layout.stops;
+        const SphereProjector& sp = layout.projector;
+
+        // Слои делятся на части, все части всех слоёв строятся параллельно в
+        // отдельные документы, которые затем склеиваются в исходном порядке:
+        // слой за слоем, часть за частью. Номер задачи совпадает с этим порядком
+        const size_t bus_chunks = (colored_buses.size() + LAYER_CHUNK_SIZE - 1) / LAYER_CHUNK_SIZE;
+        const size_t stop_chunks = (all_stops.size() + LAYER_CHUNK_SIZE - 1) / LAYER_CHUNK_SIZE;
+        std::vector<svg::Document> parts(2 * bus_chunks + 2 * stop_chunks);
+
+        const auto add_all = [](svg::Document& part, auto objects) {
+            for (auto& object : objects) {
+                part.Add(std::move(object));
+            }
+        };
+
+        parallel::ParallelFor(parts.size(), [&](size_t begin, size_t end) {
+            for (size_t task = begin; task < end; ++task) {
+                const bool is_bus_task = task < 2 * bus_chunks;
+                const size_t chunk = is_bus_task ? task % bus_chunks : (task - 2 * bus_chunks) % stop_chunks;
+                const size_t item_count = is_bus_task ? colored_buses.size() : all_stops.size();
+                const size_t first = chunk * LAYER_CHUNK_SIZE;
+                const size_t last = std::min(first + LAYER_CHUNK_SIZE, item_count);
+
+                if (task < bus_chunks) {
+                    add_all(parts[task], RenderRouteLines(colored_buses, first, last, sp));
+                }
+                else if (is_bus_task) {
+                    add_all(parts[task], GetBusLabel(colored_buses, first, last, sp));
+                }
+                else if (task < 2 * bus_chunks + stop_chunks) {
+                    add_all(parts[task], GetStopsSymbols(all_stops, first, last, sp));
+                }
+                else {
+                    add_all(parts[task], GetStopsLabels(all_stops, first, last, sp));
+                }
+            }
+        });
+
+        svg::Document result;
+        for (svg::Document& part : parts) {
+            result.Append(std::move(part));
+        }
+
+        return result;
+    }
+
+    MapIndex MapRenderer::BuildMapIndex(const std::map<std::string_view, const transport_catalogue::Bus*>& buses) const {
+        Layout layout = PrepareLayout(buses);
+        MapIndex index;
+        index.buses = std::move(layout.buses);
+        index.stops = std::move(layout.stops);
+
+        std::vector<uint32_t> stop_indices;
+        Rect bounds;
+        index.stop_points.reserve(index.stops.size());
+        for (size_t i = 0; i < index.stops.size(); ++i) {
+            const auto* stop = index.stops[i];
+            if (stop->id >= stop_indices.size()) {
+                stop_indices.resize(stop->id + 1);
+            }
+            stop_indices[stop->id] = static_cast<uint32_t>(i);
+
+            const svg::Point point = layout.projector(stop->coordinates);
+            bounds = i == 0 ? GetPointBox(point) : Rect{ std::min(bounds.min_x, point.x), std::min(bounds.min_y, point.y),
+                                                         std::max(bounds.max_x, point.x), std::max(bounds.max_y, point.y) };
+            index.stop_points.push_back(point);
+        }
+
+        index.route_offsets.reserve(index.buses.size() + 1);
+        index.route_offsets.push_back(0);
+        for (const ColoredBus& colored_bus : index.buses) {
+            for (const auto* stop : GetRouteStops(*colored_bus.bus)) {
+                index.route_stops.push_back(stop_indices[stop->id]);
+            }
+            index.route_offsets.push_back(index.route_stops.size());
+        }
+
+        index.stop_grid = SpatialGrid(bounds, index.stops.size());
+        for (size_t i = 0; i < index.stops.size(); ++i) {
+            index.stop_grid.Insert(index.stop_points[i], static_cast<uint32_t>(i));
+        }
+
+        // Ячейка сетки отрезков не мельче средней длины отрезка / SEGMENT_CELLS,
+        // так что отрезок в среднем попадает в несколько ячеек даже у сети с
+        // длинными перегонами через весь город
+        size_t segment_count = 0;
+        double total_length = 0.0;
+        for (size_t bus_index = 0; bus_index < index.buses.size(); ++bus_index) {
+            for (size_t k = index.route_offsets[bus_index]; k + 1 < index.route_offsets[bus_index + 1]; ++k) {
+                const svg::Point from = index.stop_points[index.route_stops[k]];
+                const svg::Point to = index.stop_points[index.route_stops[k + 1]];
+                total_length += std::abs(to.x - from.x) + std::abs(to.y - from.y);
+                ++segment_count;
+            }
+        }
+        const double min_cell_side = segment_count > 0 ? total_length / segment_count / SEGMENT_CELLS : 0.0;
+
+        index.segment_grid = SpatialGrid(bounds, segment_count, min_cell_side);
+        index.bus_label_grid = SpatialGrid(bounds, 2 * index.buses.size());
+        for (size_t bus_index = 0; bus_index < index.buses.size(); ++bus_index) {
+            const size_t route_begin = index.route_offsets[bus_index];
+            const size_t route_end = index.route_offsets[bus_index + 1];
+            for (size_t k = route_begin; k + 1 < route_end; ++k) {
+                index.segment_grid.Insert(index.stop_points[index.route_stops[k]], index.stop_points[index.route_stops[k + 1]],
+                                          static_cast<uint32_t>(k));
+            }
+
+            const auto* bus = index.buses[bus_index].bus;
+            const uint32_t first_stop = index.route_stops[route_begin];
+            index.bus_label_grid.Insert(index.stop_points[first_stop], static_cast<uint32_t>(2 * bus_index));
+            if (bus->is_circle == false && bus->stops[0] != bus->stops[bus->stops.size() - 1]) {
+                const uint32_t last_stop = index.route_stops[route_begin + bus->stops.size() - 1];
+                index.bus_label_grid.Insert(index.stop_points[last_stop], static_cast<uint32_t>(2 * bus_index + 1));
+            }
+        }
+
+        return index;
+    }
+
+    svg::Document MapRenderer::GetSVG(const MapIndex& index, const Rect& viewport) const {
+        svg::Document result;
+        result.SetViewBox({ viewport.min_x, viewport.min_y }, viewport.max_x - viewport.min_x, viewport.max_y - viewport.min_y);
+
+        // Отрезки приходят по возрастанию номера, то есть по автобусам и по
+        // порядку проезда. Подряд идущие видимые отрезки продолжают одну
+        // ломаную, а выход за границу начинает новую
+        std::optional<svg::Polyline> line;
+        size_t bus_index = 0;
+        size_t previous_segment = 0;
+        bool previous_reaches_end = false;
+        for (const uint32_t segment : index.segment_grid.Query(viewport)) {
+            const svg::Point from = index.stop_points[index.route_stops[segment]];
+            const svg::Point to = index.stop_points[index.route_stops[segment + 1]];
+            const auto clip = ClipSegment(from, to, viewport);
+            if (!clip) {
+                continue;
+            }
+
+            const size_t line_bus = bus_index;
+            while (index.route_offsets[bus_index + 1] <= segment) {
+                ++bus_index;
+            }
+            const bool continues_line = line && line_bus == bus_index && previous_segment + 1 == segment
+                && previous_reaches_end && clip->first == 0.0;
+            if (!continues_line) {
+                if (line) {
+                    result.Add(std::move(*line));
+                }
+                line = CreateRouteLine(index.buses[bus_index].color_index);
+                line->AddPoint(GetSegmentPoint(from, to, clip->first));
+            }
+            line->AddPoint(GetSegmentPoint(from, to, clip->second));
+            previous_segment = segment;
+            previous_reaches_end = clip->second == 1.0;
+        }
+        if (line) {
+            result.Add(std::move(*line));
+        }
+
+        // Значок остановки виден, если его круг задевает область; надписи
+        // выводятся вместе с остановками, к которым привязаны
+        const Rect stop_area = viewport.Expanded(render_settings_.stop_radius);
+
+        std::vector<svg::Text> bus_labels;
+        for (const uint32_t label : index.bus_label_grid.Query(stop_area)) {
+            const ColoredBus& colored_bus = index.buses[label / 2];
+            const size_t route_begin = index.route_offsets[label / 2];
+            const uint32_t stop = index.route_stops[label % 2 == 0 ? route_begin : route_begin + colored_bus.bus->stops.size() - 1];
+            if (stop_area.Contains(index.stop_points[stop])) {
+                AddBusLabel(bus_labels, *colored_bus.bus, colored_bus.color_index, index.stop_points[stop]);
+            }
+        }
+        for (auto& text : bus_labels) {
+            result.Add(std::move(text));
         }
-        for (const auto& text : GetBusLabel(buses, sp)) {
-            result.Add(text);
+
+        std::vector<uint32_t> visible_stops = index.stop_grid.Query(stop_area);
+        visible_stops.erase(std::remove_if(visible_stops.begin(), visible_stops.end(), [&index, &stop_area](uint32_t stop) {
+            return !stop_area.Contains(index.stop_points[stop]);
+        }), visible_stops.end());
+
+        for (const uint32_t stop : visible_stops) {
+            result.Add(CreateStopSymbol(index.stop_points[stop]));
         }
-        for (const auto& circle : GetStopsSymbols(all_stops, sp)) {
-            result.Add(circle);
+        std::vector<svg::Text> stop_labels;
+        for (const uint32_t stop : visible_stops) {
+            AddStopLabel(stop_labels, *index.stops[stop], index.stop_points[stop]);
         }
-        for (const auto& text : GetStopsLabels(all_stops, sp)) {
-            result.Add(text);
+        for (auto& text : stop_labels) {
+            result.Add(std::move(text));
         }
 
         return result;
     }
 
+    std::optional<Rect> MapRenderer::GetTileViewport(int zoom, int x, int y) const {
+        if (zoom < 0 || zoom > MAX_TILE_ZOOM) {
+            return std::nullopt;
+        }
+        const int tile_count = 1 << zoom;
+        if (x < 0 || y < 0 || x >= tile_count || y >= tile_count) {
+            return std::nullopt;
+        }
+
+        const double tile_width = render_settings_.width / tile_count;
+        const double tile_height = render_settings_.height / tile_count;
+        return Rect{ x * tile_width, y * tile_height, (x + 1) * tile_width, (y + 1) * tile_height };
+    }
+
 } // namespace renderer
\ No newline at end of file
@@ -4,8 +4,11 @@
 #include "geo.h"
 #include "json.h"
 #include "domain.h"
+#include "spatial_grid.h"
 
 #include <algorithm>
+#include <map>
+#include <optional>
 
 namespace renderer {
 
@@ -84,20 +87,81 @@ namespace renderer {
         std::vector<svg::Color> color_palette{};
     };
 
+    // Автобус с непустым маршрутом и его цветом из палитры: цвета выдаются по
+    // кругу в порядке номеров, поэтому считаются заранее для всего слоя
+    struct ColoredBus {
+        const transport_catalogue::Bus* bus;
+        size_t color_index;
+    };
+
+    // Карта, подготовленная к отрисовке фрагментов. Проекция та же, что у
+    // полной карты, поэтому фрагменты совпадают с ней и стыкуются друг с другом
+    struct MapIndex {
+        std::vector<ColoredBus> buses;
+        // Остановки по названию и их точки на карте
+        std::vector<const transport_catalogue::Stop*> stops;
+        std::vector<svg::Point> stop_points;
+        // Маршруты всех автобусов подряд в виде индексов в stops, обратный путь
+        // некольцевых маршрутов включён. Маршрут buses[i] занимает
+        // [route_offsets[i], route_offsets[i + 1])
+        std::vector<uint32_t> route_stops;
+        std::vector<size_t> route_offsets;
+        // Идентификаторы: индекс остановки; отрезок от route_stops[k] до
+        // route_stops[k + 1] - число k; надпись автобуса i у первой конечной -
+        // 2 * i, у второй - 2 * i + 1
+        SpatialGrid stop_grid;
+        SpatialGrid segment_grid;
+        SpatialGrid bus_label_grid;
+    };
+
     class MapRenderer {
     public:
         MapRenderer(const RenderSettings& render_settings)
             : render_settings_(render_settings)
         {}
 
-        std::vector<svg::Polyline> RenderRouteLines(const std::map<std::string_view, const transport_catalogue::Bus*>& buses, const SphereProjector& sp) const;
-        std::vector<svg::Text> GetBusLabel(const std::map<std::string_view, const transport_catalogue::Bus*>& buses, const SphereProjector& sp) const;
-        std::vector<svg::Circle> GetStopsSymbols(const std::map<std::string_view, const transport_catalogue::Stop*>& stops, const SphereProjector& sp) const;
-        std::vector<svg::Text> GetStopsLabels(const std::map<std::string_view, const transport_catalogue::Stop*>& stops, const SphereProjector& sp) const;
+        // Каждый слой строится для части [begin, end) своих элементов, чтобы
+        // части можно было строить независимо и склеивать по порядку
+        std::vector<svg::Polyline> RenderRouteLines(const std::vector<ColoredBus>& buses, size_t begin, size_t end, const SphereProjector& sp) const;
+        std::vector<svg::Text> GetBusLabel(const std::vector<ColoredBus>& buses, size_t begin, size_t end, const SphereProjector& sp) const;
+        // stops - остановки, упорядоченные по названию
+        std::vector<svg::Circle> GetStopsSymbols(const std::vector<const transport_catalogue::Stop*>& stops, size_t begin, size_t end, const SphereProjector& sp) const;
+        std::vector<svg::Text> GetStopsLabels(const std::vector<const transport_catalogue::Stop*>& stops, size_t begin, size_t end, const SphereProjector& sp) const;
 
         svg::Document GetSVG(const std::map<std::string_view, const transport_catalogue::Bus*>& buses) const;
 
+        MapIndex BuildMapIndex(const std::map<std::string_view, const transport_catalogue::Bus*>& buses) const;
+        // Фрагмент карты в прямоугольнике viewport. Ломаные обрезаются по его
+        // границе, остановки и надписи выводятся, если их остановка попадает
+        // в него с учётом радиуса значка. Порядок слоёв и объектов тот же, что
+        // у полной карты
+        svg::Document GetSVG(const MapIndex& index, const Rect& viewport) const;
+
+        // Плитка x, y уровня zoom: холст делится на 2^zoom x 2^zoom частей,
+        // x растёт вправо, y - вниз. nullopt для несуществующей плитки
+        std::optional<Rect> GetTileViewport(int zoom, int x, int y) const;
+
     private:
+        // Число автобусов или остановок в одной части слоя
+        static constexpr size_t LAYER_CHUNK_SIZE = 256;
+        static constexpr int MAX_TILE_ZOOM = 24;
+        // Во сколько ячеек в среднем попадает отрезок маршрута в индексе карты
+        static constexpr double SEGMENT_CELLS = 4.0;
+
+        // Автобусы с непустыми маршрутами, их остановки по названию и проекция
+        struct Layout {
+            std::vector<ColoredBus> buses;
+            std::vector<const transport_catalogue::Stop*> stops;
+            SphereProjector projector;
+        };
+
+        Layout PrepareLayout(const std::map<std::string_view, const transport_catalogue::Bus*>& buses) const;
+
+        svg::Polyline CreateRouteLine(size_t color_index) const;
+        void AddBusLabel(std::vector<svg::Text>& result, const transport_catalogue::Bus& bus, size_t color_index, svg::Point position) const;
+        svg::Circle CreateStopSymbol(svg::Point position) const;
+        void AddStopLabel(std::vector<svg::Text>& result, const transport_catalogue::Stop& stop, svg::Point position) const;
+
         const RenderSettings render_settings_;
     };
 
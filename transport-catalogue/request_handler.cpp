@@ -1,28 +1,28 @@
 #include "request_handler.h"
 
-std::optional<transport_catalogue::BusStat> RequestHandler::RouteInformation(const std::string_view bus_number) const {
-    const transport_catalogue::Bus* bus = catalogue_.FindRoute(bus_number);
-
-    if (!bus) {
-        throw std::invalid_argument("bus not found");
-    }
-
-    return catalogue_.CalculateBusStat(bus);
+const transport_catalogue::Bus* RequestHandler::FindBus(const std::string_view bus_number) const {
+    return catalogue_.FindRoute(bus_number);
 }
 
-const std::set<std::string> RequestHandler::GetBusesByStop(std::string_view stop_name) const {
-    return catalogue_.FindStop(stop_name)->buses_by_stop;
+const transport_catalogue::Stop* RequestHandler::FindStop(const std::string_view stop_name) const {
+    return catalogue_.FindStop(stop_name);
 }
 
-bool RequestHandler::IsBusNumber(const std::string_view bus_number) const {
-    return catalogue_.FindRoute(bus_number);
+transport_catalogue::BusStat RequestHandler::RouteInformation(const transport_catalogue::BusId bus_id) const {
+    return catalogue_.GetBusStat(catalogue_.GetBus(bus_id));
 }
 
-bool RequestHandler::IsStopName(const std::string_view stop_name) const {
-    return catalogue_.FindStop(stop_name);
+std::vector<std::string_view> RequestHandler::GetBusesByStop(const transport_catalogue::StopId stop_id) const {
+    std::vector<std::string_view> result;
+    const auto& bus_ids = catalogue_.GetStopBuses(stop_id);
+    result.reserve(bus_ids.size());
+    for (const transport_catalogue::BusId bus_id : bus_ids) {
+        result.push_back(catalogue_.GetBus(bus_id)->number);
+    }
+    return result;
 }
 
-const std::optional<graph::Router<double>::RouteInfo> RequestHandler::GetOptimalRoute(const std::string_view stop_from, const std::string_view stop_to) const {
+const std::optional<transport_catalogue::RouteInfo> RequestHandler::GetOptimalRoute(const transport_catalogue::StopId stop_from, const transport_catalogue::StopId stop_to) const {
     return router_.FindRoute(stop_from, stop_to);
 }
 
@@ -32,4 +32,40 @@ const graph::DirectedWeightedGraph<double>& RequestHandler::GetRouterGraph() con
 
 svg::Document RequestHandler::RenderMap() const {
     return renderer_.GetSVG(catalogue_.GetBusesOnStop());
+}
+
+std::shared_ptr<const RequestHandler::RenderedMap> RequestHandler::GetRenderedMap() const {
+    std::lock_guard guard(map_mutex_);
+    const uint64_t version = catalogue_.GetVersion();
+    if (rendered_map_ && rendered_map_->catalogue_version == version) {
+        return rendered_map_;
+    }
+
+    auto map = std::make_shared<RenderedMap>();
+    map->catalogue_version = version;
+    RenderMap().Render(map->svg);
+    json::PrintString(map->svg, map->json_literal);
+    rendered_map_ = std::move(map);
+    return rendered_map_;
+}
+
+std::string RequestHandler::RenderMapFragment(const renderer::Rect& viewport) const {
+    std::shared_ptr<const renderer::MapIndex> index;
+    {
+        std::lock_guard guard(map_index_mutex_);
+        const uint64_t version = catalogue_.GetVersion();
+        if (!map_index_ || map_index_version_ != version) {
+            map_index_ = std::make_shared<renderer::MapIndex>(renderer_.BuildMapIndex(catalogue_.GetBusesOnStop()));
+            map_index_version_ = version;
+        }
+        index = map_index_;
+    }
+
+    std::string result;
+    renderer_.GetSVG(*index, viewport).Render(result);
+    return result;
+}
+
+std::optional<renderer::Rect> RequestHandler::GetTileViewport(int zoom, int x, int y) const {
+    return renderer_.GetTileViewport(zoom, x, y);
 }
\ No newline at end of file
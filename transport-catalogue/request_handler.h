@@ -5,7 +5,9 @@
 #include "map_renderer.h"
 #include "transport_router.h"
 
-#include <sstream>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <optional>
 
 class RequestHandler {
@@ -21,19 +23,46 @@ public:
     {
     }
 
-    std::optional<transport_catalogue::BusStat> RouteInformation(const std::string_view bus_number) const;
+    // Поиск по имени выполняется один раз на запрос, дальше работа идёт по идентификаторам
+    const transport_catalogue::Bus* FindBus(const std::string_view bus_number) const;
+    const transport_catalogue::Stop* FindStop(const std::string_view stop_name) const;
 
-    const std::set<std::string> GetBusesByStop(std::string_view stop_name) const;
-    bool IsBusNumber(const std::string_view bus_number) const;
-    bool IsStopName(const std::string_view stop_name) const;
+    transport_catalogue::BusStat RouteInformation(const transport_catalogue::BusId bus_id) const;
 
-    const std::optional<graph::Router<double>::RouteInfo> GetOptimalRoute(const std::string_view stop_from, const std::string_view stop_to) const;
+    // Номера автобусов, проходящих через остановку, в алфавитном порядке
+    std::vector<std::string_view> GetBusesByStop(const transport_catalogue::StopId stop_id) const;
+
+    const std::optional<transport_catalogue::RouteInfo> GetOptimalRoute(const transport_catalogue::StopId stop_from, const transport_catalogue::StopId stop_to) const;
     const graph::DirectedWeightedGraph<double>& GetRouterGraph() const;
 
     svg::Document RenderMap() const;
 
+    // Карта в SVG и она же в виде строкового литерала JSON
+    struct RenderedMap {
+        uint64_t catalogue_version = 0;
+        std::string svg;
+        std::string json_literal;
+    };
+
+    // Карта строится при первом запросе и затем переиспользуется, пока не
+    // изменится версия каталога; настройки отрисовки у обработчика постоянные.
+    // Можно вызывать из нескольких потоков, карту строит только один из них
+    std::shared_ptr<const RenderedMap> GetRenderedMap() const;
+
+    // Фрагмент карты в SVG. Индекс карты для поиска видимых объектов
+    // кешируется так же, как карта целиком
+    std::string RenderMapFragment(const renderer::Rect& viewport) const;
+    std::optional<renderer::Rect> GetTileViewport(int zoom, int x, int y) const;
+
 private:
     const transport_catalogue::TransportCatalogue& catalogue_;
     const renderer::MapRenderer& renderer_;
     const transport_catalogue::Router& router_;
+
+    mutable std::mutex map_mutex_;
+    mutable std::shared_ptr<const RenderedMap> rendered_map_;
+
+    mutable std::mutex map_index_mutex_;
+    mutable uint64_t map_index_version_ = 0;
+    mutable std::shared_ptr<const renderer::MapIndex> map_index_;
 };
\ No newline at end of file
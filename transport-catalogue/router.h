@@ -6,6 +6,8 @@
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <unordered_map>
@@ -14,20 +16,91 @@
 
 namespace graph {
 
+    // Общий интерфейс движков поиска кратчайшего пути
     template <typename Weight>
-    class Router {
-    private:
-        using Graph = DirectedWeightedGraph<Weight>;
-
+    class RouterBase {
     public:
-        explicit Router(const Graph& graph);
-
         struct RouteInfo {
             Weight weight;
             std::vector<EdgeId> edges;
         };
 
-        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+        virtual ~RouterBase() = default;
+
+        virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
+    };
+
+    // Пул рабочих буферов поиска по запросу. Буферы переиспользуются между
+    // запросами, а одновременные запросы из разных потоков получают разные экземпляры
+    template <typename State>
+    class SearchStatePool {
+    public:
+        class Lease {
+        public:
+            Lease(const SearchStatePool& pool, std::unique_ptr<State> state)
+                : pool_(pool)
+                , state_(std::move(state)) {
+            }
+
+            Lease(const Lease&) = delete;
+            Lease& operator=(const Lease&) = delete;
+
+            ~Lease() {
+                pool_.Release(std::move(state_));
+            }
+
+            State& operator*() const {
+                return *state_;
+            }
+
+            State* operator->() const {
+                return state_.get();
+            }
+
+        private:
+            const SearchStatePool& pool_;
+            std::unique_ptr<State> state_;
+        };
+
+        explicit SearchStatePool(size_t vertex_count)
+            : vertex_count_(vertex_count) {
+        }
+
+        Lease Acquire() const {
+            {
+                std::lock_guard guard(mutex_);
+                if (!free_states_.empty()) {
+                    auto state = std::move(free_states_.back());
+                    free_states_.pop_back();
+                    return Lease(*this, std::move(state));
+                }
+            }
+            return Lease(*this, std::make_unique<State>(vertex_count_));
+        }
+
+    private:
+        void Release(std::unique_ptr<State> state) const {
+            std::lock_guard guard(mutex_);
+            free_states_.push_back(std::move(state));
+        }
+
+        size_t vertex_count_;
+        mutable std::mutex mutex_;
+        mutable std::vector<std::unique_ptr<State>> free_states_;
+    };
+
+    // Предподсчёт всех пар вершин (Флойд-Уоршелл): O(V^3) на построение, O(V^2) памяти
+    template <typename Weight>
+    class Router final : public RouterBase<Weight> {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+        explicit Router(const Graph& graph);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
 
     private:
         struct RouteInternalData {
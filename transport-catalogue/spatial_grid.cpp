@@ -0,0 +1,90 @@
+#include "spatial_grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace renderer {
+
+    SpatialGrid::SpatialGrid(const Rect& bounds, size_t expected_count, double min_cell_side)
+        : bounds_(bounds)
+    {
+        // Ячейки близки к квадратным, а их число - к expected_count / ITEMS_PER_CELL
+        const double width = std::max(bounds.max_x - bounds.min_x, 1e-9);
+        const double height = std::max(bounds.max_y - bounds.min_y, 1e-9);
+        const double cell_count = std::max<double>(1.0, static_cast<double>(expected_count) / ITEMS_PER_CELL);
+        const double cell_side = std::max(std::sqrt(width * height / cell_count), min_cell_side);
+        columns_ = std::clamp<size_t>(static_cast<size_t>(std::ceil(width / cell_side)), 1, MAX_SIDE_CELLS);
+        rows_ = std::clamp<size_t>(static_cast<size_t>(std::ceil(height / cell_side)), 1, MAX_SIDE_CELLS);
+        cell_width_ = width / columns_;
+        cell_height_ = height / rows_;
+        cells_.resize(columns_ * rows_);
+    }
+
+    size_t SpatialGrid::GetColumn(double x) const {
+        const double column = std::floor((x - bounds_.min_x) / cell_width_);
+        return static_cast<size_t>(std::clamp(column, 0.0, static_cast<double>(columns_ - 1)));
+    }
+
+    size_t SpatialGrid::GetRow(double y) const {
+        const double row = std::floor((y - bounds_.min_y) / cell_height_);
+        return static_cast<size_t>(std::clamp(row, 0.0, static_cast<double>(rows_ - 1)));
+    }
+
+    void SpatialGrid::Insert(svg::Point point, uint32_t id) {
+        cells_[GetRow(point.y) * columns_ + GetColumn(point.x)].push_back(id);
+    }
+
+    void SpatialGrid::Insert(svg::Point from, svg::Point to, uint32_t id) {
+        // Проход по ячейкам вдоль отрезка (Амантидес - Ву). Каждый шаг
+        // приближает к ячейке конца, поэтому погрешность вычислений не может
+        // увести проход в сторону или зациклить его
+        size_t column = GetColumn(from.x);
+        size_t row = GetRow(from.y);
+        const size_t last_column = GetColumn(to.x);
+        const size_t last_row = GetRow(to.y);
+
+        const double dx = to.x - from.x;
+        const double dy = to.y - from.y;
+        const double next_x = bounds_.min_x + (dx > 0 ? column + 1 : column) * cell_width_;
+        const double next_y = bounds_.min_y + (dy > 0 ? row + 1 : row) * cell_height_;
+        double t_max_x = dx != 0.0 ? (next_x - from.x) / dx : std::numeric_limits<double>::infinity();
+        double t_max_y = dy != 0.0 ? (next_y - from.y) / dy : std::numeric_limits<double>::infinity();
+        const double t_delta_x = dx != 0.0 ? cell_width_ / std::abs(dx) : 0.0;
+        const double t_delta_y = dy != 0.0 ? cell_height_ / std::abs(dy) : 0.0;
+
+        cells_[row * columns_ + column].push_back(id);
+        while (column != last_column || row != last_row) {
+            const bool step_column = row == last_row || (column != last_column && t_max_x < t_max_y);
+            if (step_column) {
+                column = dx > 0 ? column + 1 : column - 1;
+                t_max_x += t_delta_x;
+            }
+            else {
+                row = dy > 0 ? row + 1 : row - 1;
+                t_max_y += t_delta_y;
+            }
+            cells_[row * columns_ + column].push_back(id);
+        }
+    }
+
+    std::vector<uint32_t> SpatialGrid::Query(const Rect& area) const {
+        std::vector<uint32_t> result;
+        if (cells_.empty() || !bounds_.Intersects(area)) {
+            return result;
+        }
+
+        const size_t last_column = GetColumn(area.max_x);
+        const size_t last_row = GetRow(area.max_y);
+        for (size_t row = GetRow(area.min_y); row <= last_row; ++row) {
+            for (size_t column = GetColumn(area.min_x); column <= last_column; ++column) {
+                const auto& cell = cells_[row * columns_ + column];
+                result.insert(result.end(), cell.begin(), cell.end());
+            }
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+} // namespace renderer
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "svg.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace renderer {
+
+    // Прямоугольник в координатах карты; y растёт вниз, как в SVG
+    struct Rect {
+        double min_x = 0.0;
+        double min_y = 0.0;
+        double max_x = 0.0;
+        double max_y = 0.0;
+
+        bool Contains(svg::Point point) const {
+            return point.x >= min_x && point.x <= max_x && point.y >= min_y && point.y <= max_y;
+        }
+
+        bool Intersects(const Rect& other) const {
+            return other.min_x <= max_x && other.max_x >= min_x && other.min_y <= max_y && other.max_y >= min_y;
+        }
+
+        Rect Expanded(double margin) const {
+            return { min_x - margin, min_y - margin, max_x + margin, max_y + margin };
+        }
+    };
+
+    // Равномерная сетка над ограничивающим прямоугольником элементов. Элемент
+    // записывается во все ячейки, которые он задевает, поэтому запрос
+    // возвращает кандидатов, а точную проверку делает вызывающий
+    class SpatialGrid {
+    public:
+        SpatialGrid() = default;
+        // expected_count - примерное число элементов, по нему выбирается размер
+        // ячейки. min_cell_side ограничивает его снизу, чтобы длинные элементы
+        // не размножались по слишком многим ячейкам
+        SpatialGrid(const Rect& bounds, size_t expected_count, double min_cell_side = 0.0);
+
+        void Insert(svg::Point point, uint32_t id);
+        // Отрезок записывается только в ячейки, которые он пересекает
+        void Insert(svg::Point from, svg::Point to, uint32_t id);
+
+        // Элементы из ячеек, задевающих area, по возрастанию id и без повторов
+        std::vector<uint32_t> Query(const Rect& area) const;
+
+    private:
+        // Сколько элементов в среднем приходится на ячейку
+        static constexpr size_t ITEMS_PER_CELL = 4;
+        static constexpr size_t MAX_SIDE_CELLS = 1024;
+
+        size_t GetColumn(double x) const;
+        size_t GetRow(double y) const;
+
+        Rect bounds_;
+        size_t columns_ = 0;
+        size_t rows_ = 0;
+        double cell_width_ = 1.0;
+        double cell_height_ = 1.0;
+        std::vector<std::vector<uint32_t>> cells_;
+    };
+
+} // namespace renderer
\ No newline at end of file
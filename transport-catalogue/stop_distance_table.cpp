@@ -0,0 +1,111 @@
+#include "stop_distance_table.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace transport_catalogue {
+
+    namespace {
+
+        // Заполнение таблицы не превышает 1/2
+        constexpr size_t MIN_SLOT_COUNT = 16;
+
+        size_t GetSlotCountFor(size_t count) {
+            size_t slot_count = MIN_SLOT_COUNT;
+            while (slot_count < count * 2) {
+                slot_count *= 2;
+            }
+            return slot_count;
+        }
+
+        // Финализатор splitmix64: хорошо перемешивает соседние идентификаторы
+        uint64_t MixBits(uint64_t value) {
+            value ^= value >> 30;
+            value *= 0xbf58476d1ce4e5b9ULL;
+            value ^= value >> 27;
+            value *= 0x94d049bb133111ebULL;
+            value ^= value >> 31;
+            return value;
+        }
+
+    } // namespace
+
+    uint64_t StopDistanceTable::PackKey(StopId from, StopId to) {
+        return (static_cast<uint64_t>(from) << 32) | to;
+    }
+
+    size_t StopDistanceTable::GetStartSlot(StopId from, StopId to) const {
+        const auto [low, high] = std::minmax(from, to);
+        return MixBits(PackKey(low, high)) & (slots_.size() - 1);
+    }
+
+    void StopDistanceTable::Reserve(size_t count) {
+        if (count * 2 > slots_.size()) {
+            Rehash(GetSlotCountFor(count));
+        }
+    }
+
+    void StopDistanceTable::Rehash(size_t slot_count) {
+        std::vector<Slot> old_slots(slot_count, Slot{ EMPTY_KEY, 0 });
+        std::swap(slots_, old_slots);
+        size_ = 0;
+        for (const Slot& slot : old_slots) {
+            if (slot.key != EMPTY_KEY) {
+                Insert(static_cast<StopId>(slot.key >> 32), static_cast<StopId>(slot.key), slot.distance);
+            }
+        }
+    }
+
+    void StopDistanceTable::Insert(StopId from, StopId to, int distance) {
+        const uint64_t key = PackKey(from, to);
+        const size_t mask = slots_.size() - 1;
+        for (size_t slot = GetStartSlot(from, to);; slot = (slot + 1) & mask) {
+            if (slots_[slot].key == key) {
+                slots_[slot].distance = distance;
+                return;
+            }
+            if (slots_[slot].key == EMPTY_KEY) {
+                slots_[slot] = { key, distance };
+                ++size_;
+                return;
+            }
+        }
+    }
+
+    void StopDistanceTable::Set(StopId from, StopId to, int distance) {
+        Reserve(size_ + 1);
+        Insert(from, to, distance);
+    }
+
+    void StopDistanceTable::SetBulk(const std::vector<Entry>& entries) {
+        Reserve(size_ + entries.size());
+        for (const Entry& entry : entries) {
+            Insert(entry.from, entry.to, entry.distance);
+        }
+    }
+
+    int StopDistanceTable::Get(StopId from, StopId to) const {
+        if (slots_.empty()) {
+            return 0;
+        }
+
+        const uint64_t key = PackKey(from, to);
+        const uint64_t reverse_key = PackKey(to, from);
+        const size_t mask = slots_.size() - 1;
+        int result = 0;
+        for (size_t slot = GetStartSlot(from, to); slots_[slot].key != EMPTY_KEY; slot = (slot + 1) & mask) {
+            if (slots_[slot].key == key) {
+                return slots_[slot].distance;
+            }
+            if (slots_[slot].key == reverse_key) {
+                result = slots_[slot].distance;
+            }
+        }
+        return result;
+    }
+
+    size_t StopDistanceTable::GetSize() const {
+        return size_;
+    }
+
+} // namespace transport_catalogue
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "domain.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace transport_catalogue {
+
+    // Таблица дорожных расстояний с открытой адресацией. Ключ - упакованная
+    // в 64 бита пара (from, to). Хеш считается от неупорядоченной пары, поэтому
+    // оба направления лежат в одной цепочке проб, и запасной поиск обратного
+    // направления не требует второго прохода
+    class StopDistanceTable {
+    public:
+        struct Entry {
+            StopId from;
+            StopId to;
+            int distance;
+        };
+
+        void Reserve(size_t count);
+
+        void Set(StopId from, StopId to, int distance);
+        void SetBulk(const std::vector<Entry>& entries);
+
+        // Расстояние from -> to, а если оно не задано - to -> from; иначе 0
+        int Get(StopId from, StopId to) const;
+
+        size_t GetSize() const;
+
+    private:
+        struct Slot {
+            uint64_t key;
+            int distance;
+        };
+
+        static constexpr uint64_t EMPTY_KEY = UINT64_MAX;
+
+        static uint64_t PackKey(StopId from, StopId to);
+        size_t GetStartSlot(StopId from, StopId to) const;
+        void Rehash(size_t slot_count);
+        void Insert(StopId from, StopId to, int distance);
+
+        std::vector<Slot> slots_;
+        size_t size_ = 0;
+    };
+
+} // namespace transport_catalogue
\ No newline at end of file
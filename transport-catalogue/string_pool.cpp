@@ -0,0 +1,41 @@
+#include "string_pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace transport_catalogue {
+
+    std::string_view StringPool::Intern(std::string_view value) {
+        if (auto it = strings_.find(value); it != strings_.end()) {
+            return *it;
+        }
+        const std::string_view stored = Store(value);
+        strings_.insert(stored);
+        return stored;
+    }
+
+    size_t StringPool::GetSize() const {
+        return strings_.size();
+    }
+
+    std::string_view StringPool::Store(std::string_view value) {
+        if (static_cast<size_t>(end_ - pos_) < value.size()) {
+            // Длинные строки получают собственный блок, не расходуя текущий
+            const size_t block_size = std::max(BLOCK_SIZE, value.size());
+            blocks_.push_back(std::make_unique<char[]>(block_size));
+            if (block_size > BLOCK_SIZE) {
+                std::memcpy(blocks_.back().get(), value.data(), value.size());
+                return { blocks_.back().get(), value.size() };
+            }
+            pos_ = blocks_.back().get();
+            end_ = pos_ + block_size;
+        }
+        if (!value.empty()) {
+            std::memcpy(pos_, value.data(), value.size());
+        }
+        const std::string_view stored(pos_, value.size());
+        pos_ += value.size();
+        return stored;
+    }
+
+} // namespace transport_catalogue
\ No newline at end of file
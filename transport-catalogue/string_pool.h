@@ -0,0 +1,34 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace transport_catalogue {
+
+    // Хранилище имён: каждая различная строка копируется один раз в крупный
+    // блок памяти, а все слои справочника ссылаются на неё через string_view.
+    // Адреса строк не меняются до разрушения пула
+    class StringPool {
+    public:
+        StringPool() = default;
+        StringPool(const StringPool&) = delete;
+        StringPool& operator=(const StringPool&) = delete;
+
+        std::string_view Intern(std::string_view value);
+
+        size_t GetSize() const;
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+        std::string_view Store(std::string_view value);
+
+        std::unordered_set<std::string_view> strings_;
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        char* pos_ = nullptr;
+        char* end_ = nullptr;
+    };
+
+} // namespace transport_catalogue
\ No newline at end of file
@@ -1,55 +1,135 @@
 #include "svg.h"
 
+#include <charconv>
+#include <functional>
+#include <type_traits>
+
 namespace svg {
 
     using namespace std::literals;
 
-    std::ostream& operator<<(std::ostream& out, Color& color) {
-        std::visit(ColorPrinter{ out }, color);
-        return out;
-    }
-    std::ostream& operator<<(std::ostream& out, StrokeLineCap line_cap) {
+    std::string_view ToString(StrokeLineCap line_cap) {
         switch (line_cap) {
         case StrokeLineCap::BUTT:
-            out << "butt"sv;
-            break;
+            return "butt"sv;
         case StrokeLineCap::ROUND:
-            out << "round"sv;
-            break;
+            return "round"sv;
         case StrokeLineCap::SQUARE:
-            out << "square"sv;
-            break;
+            return "square"sv;
         }
-        return out;
+        return {};
     }
 
-    std::ostream& operator<<(std::ostream& out, StrokeLineJoin line_join) {
+    std::string_view ToString(StrokeLineJoin line_join) {
         switch (line_join) {
         case StrokeLineJoin::ARCS:
-            out << "arcs"sv;
-            break;
+            return "arcs"sv;
         case StrokeLineJoin::BEVEL:
-            out << "bevel"sv;
-            break;
+            return "bevel"sv;
         case StrokeLineJoin::MITER:
-            out << "miter"sv;
-            break;
+            return "miter"sv;
         case StrokeLineJoin::MITER_CLIP:
-            out << "miter-clip"sv;
-            break;
+            return "miter-clip"sv;
         case StrokeLineJoin::ROUND:
-            out << "round"sv;
-            break;
+            return "round"sv;
         }
-        return out;
+        return {};
     }
 
-    void Object::Render(const RenderContext& context) const {
-        context.RenderIndent();
+    namespace {
+
+        size_t HashColor(const std::optional<Color>& color) {
+            if (!color) {
+                return 0;
+            }
+            const size_t index_hash = color->index() + 1;
+            if (const auto* name = std::get_if<std::string>(&*color)) {
+                return index_hash ^ std::hash<std::string>{}(*name);
+            }
+            if (const auto* rgb = std::get_if<Rgb>(&*color)) {
+                return index_hash ^ (rgb->red << 8 | rgb->green << 16 | rgb->blue << 24);
+            }
+            if (const auto* rgba = std::get_if<Rgba>(&*color)) {
+                return index_hash ^ (rgba->red << 8 | rgba->green << 16 | rgba->blue << 24)
+                    ^ std::hash<double>{}(rgba->opacity);
+            }
+            return index_hash;
+        }
+
+        void CombineHash(size_t& seed, size_t value) {
+            seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+        }
+
+        // Запись совпадает с std::ostream << value в локали по умолчанию:
+        // %g с точностью 6
+        void AppendNumber(std::string& out, double value) {
+            char buffer[32];
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+            out.append(buffer, result.ptr);
+        }
+
+        void AppendNumber(std::string& out, uint32_t value) {
+            char buffer[16];
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, result.ptr);
+        }
+
+        void AppendRgb(std::string& out, Rgb color) {
+            AppendNumber(out, uint32_t{ color.red });
+            out += ',';
+            AppendNumber(out, uint32_t{ color.green });
+            out += ',';
+            AppendNumber(out, uint32_t{ color.blue });
+        }
+
+        void AppendColor(std::string& out, const Color& color) {
+            if (const auto* name = std::get_if<std::string>(&color)) {
+                out += *name;
+            }
+            else if (const auto* rgb = std::get_if<Rgb>(&color)) {
+                out += "rgb("sv;
+                AppendRgb(out, *rgb);
+                out += ')';
+            }
+            else if (const auto* rgba = std::get_if<Rgba>(&color)) {
+                out += "rgba("sv;
+                AppendRgb(out, *rgba);
+                out += ',';
+                AppendNumber(out, rgba->opacity);
+                out += ')';
+            }
+            else {
+                out += "none"sv;
+            }
+        }
+
+        void AppendPoint(std::string& out, Point point) {
+            AppendNumber(out, point.x);
+            out += ',';
+            AppendNumber(out, point.y);
+        }
+
+    }  // namespace
 
-        RenderObject(context);
+    bool Style::operator==(const Style& rhs) const {
+        return fill_color == rhs.fill_color
+            && stroke_color == rhs.stroke_color
+            && width == rhs.width
+            && line_cap == rhs.line_cap
+            && line_join == rhs.line_join
+            && font_family == rhs.font_family
+            && font_weight == rhs.font_weight;
+    }
 
-        context.out << std::endl;
+    size_t StyleHasher::operator()(const Style& style) const {
+        size_t seed = HashColor(style.fill_color);
+        CombineHash(seed, HashColor(style.stroke_color));
+        CombineHash(seed, style.width ? std::hash<double>{}(*style.width) : 0);
+        CombineHash(seed, style.line_cap ? static_cast<size_t>(*style.line_cap) + 1 : 0);
+        CombineHash(seed, style.line_join ? static_cast<size_t>(*style.line_join) + 1 : 0);
+        CombineHash(seed, std::hash<std::string>{}(style.font_family));
+        CombineHash(seed, std::hash<std::string>{}(style.font_weight));
+        return seed;
     }
 
     // - Circle -
@@ -64,15 +144,6 @@ namespace svg {
         return *this;
     }
 
-    void Circle::RenderObject(const RenderContext& context) const {
-        auto& out = context.out;
-        out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\" "sv;
-        out << "r=\""sv << radius_ << "\""sv;
-
-        RenderAttrs(context.out);
-        out << "/>"sv;
-    }
-
     // - Polyline -
 
     Polyline& Polyline::AddPoint(Point point) {
@@ -80,25 +151,6 @@ namespace svg {
         return *this;
     }
 
-    void Polyline::RenderObject(const RenderContext& context) const {
-        auto& out = context.out;
-        out << "<polyline points=\""sv;
-        bool is_first = true;
-        for (auto& point : points_) {
-            if (is_first) {
-                out << point.x << "," << point.y;
-                is_first = false;
-            }
-            else {
-                out << " "sv << point.x << "," << point.y;
-            }
-        }
-        out << "\"";
-
-        RenderAttrs(context.out);
-        out << "/>"sv;
-    }
-
     // - Text -
 
     Text& Text::SetPosition(Point pos) {
@@ -117,12 +169,12 @@ namespace svg {
     }
 
     Text& Text::SetFontFamily(std::string font_family) {
-        font_family_ = std::move(font_family);
+        style_.font_family = std::move(font_family);
         return *this;
     }
 
     Text& Text::SetFontWeight(std::string font_weight) {
-        font_weight_ = std::move(font_weight);
+        style_.font_weight = std::move(font_weight);
         return *this;
     }
 
@@ -131,33 +183,213 @@ namespace svg {
         return *this;
     }
 
-    void Text::RenderObject(const RenderContext& context) const {
-        auto& out = context.out;
-        out << "<text";
+    // - Document -
 
-        RenderAttrs(context.out);
-        out << " x=\""sv << pos_.x << "\" y=\""sv << pos_.y << "\" "sv;
-        out << "dx=\""sv << offset_.x << "\" dy=\""sv << offset_.y << "\" "sv;
-        out << "font-size=\""sv << size_ << "\""sv;
-        if (!font_family_.empty()) out << " font-family=\""sv << font_family_ << "\" "sv;
-        if (!font_weight_.empty()) out << "font-weight=\""sv << font_weight_ << "\""sv;
-        out << ">"sv << data_ << "</text>"sv;
+    void Document::Add(const Circle& circle) {
+        objects_.push_back(CircleRecord{ circle.GetCenter(), circle.GetRadius(), InternStyle(circle.GetStyle()) });
     }
 
-    // - Document -
+    void Document::Add(const Polyline& polyline) {
+        const auto& points = polyline.GetPoints();
+        objects_.push_back(PolylineRecord{ points_.size(), points.size(), InternStyle(polyline.GetStyle()) });
+        points_.insert(points_.end(), points.begin(), points.end());
+    }
 
-    void Document::AddPtr(std::unique_ptr<Object>&& obj) {
-        objects_.emplace_back(std::move(obj));
+    void Document::Add(const Text& text) {
+        const std::string& data = text.GetData();
+        objects_.push_back(TextRecord{ text.GetPosition(), text.GetOffset(), text.GetFontSize(),
+            InternStyle(text.GetStyle()), text_data_.size(), data.size() });
+        text_data_ += data;
     }
 
-    void Document::Render(std::ostream& out) const {
-        RenderContext ctx(out, 2, 2);
-        out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
-        out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << std::endl;
-        for (const auto& obj : objects_) {
-            obj->Render(ctx);
+    void Document::Add(Polyline&& polyline) {
+        std::vector<Point> points = std::move(polyline.points_);
+        objects_.push_back(PolylineRecord{ points_.size(), points.size(), InternStyle(polyline.GetStyle()) });
+        if (points_.empty()) {
+            points_ = std::move(points);
+        }
+        else {
+            points_.insert(points_.end(), points.begin(), points.end());
         }
-        out << "</svg>"sv;
+    }
+
+    void Document::Add(Text&& text) {
+        std::string data = std::move(text.data_);
+        objects_.push_back(TextRecord{ text.GetPosition(), text.GetOffset(), text.GetFontSize(),
+            InternStyle(text.GetStyle()), text_data_.size(), data.size() });
+        if (text_data_.empty()) {
+            text_data_ = std::move(data);
+        }
+        else {
+            text_data_ += data;
+        }
+    }
+
+    void Document::Append(Document&& other) {
+        if (objects_.empty() && styles_.empty()) {
+            const std::optional<ViewBox> view_box = view_box_;
+            *this = std::move(other);
+            view_box_ = view_box;
+            return;
+        }
+
+        std::vector<uint32_t> style_map(other.styles_.size());
+        for (const auto& [style, id] : other.style_ids_) {
+            style_map[id] = InternStyle(style);
+        }
+
+        const size_t point_base = points_.size();
+        const size_t text_base = text_data_.size();
+        points_.insert(points_.end(), other.points_.begin(), other.points_.end());
+        text_data_ += other.text_data_;
+
+        for (auto& object : other.objects_) {
+            std::visit([&](auto& record) {
+                using Record = std::decay_t<decltype(record)>;
+                record.style = style_map[record.style];
+                if constexpr (std::is_same_v<Record, PolylineRecord>) {
+                    record.first_point += point_base;
+                }
+                else if constexpr (std::is_same_v<Record, TextRecord>) {
+                    record.data_begin += text_base;
+                }
+            }, object);
+            objects_.push_back(object);
+        }
+        other = Document{};
+    }
+
+    void Document::SetViewBox(Point origin, double width, double height) {
+        view_box_ = ViewBox{ origin, width, height };
+    }
+
+    uint32_t Document::InternStyle(const Style& style) {
+        const auto [it, inserted] = style_ids_.emplace(style, static_cast<uint32_t>(styles_.size()));
+        if (!inserted) {
+            return it->second;
+        }
+
+        std::string path_attrs;
+        if (style.fill_color) {
+            path_attrs += " fill=\""sv;
+            AppendColor(path_attrs, *style.fill_color);
+            path_attrs += '"';
+        }
+        if (style.stroke_color) {
+            path_attrs += " stroke=\""sv;
+            AppendColor(path_attrs, *style.stroke_color);
+            path_attrs += '"';
+        }
+        if (style.width) {
+            path_attrs += " stroke-width=\""sv;
+            AppendNumber(path_attrs, *style.width);
+            path_attrs += '"';
+        }
+        if (style.line_cap) {
+            path_attrs += " stroke-linecap=\""sv;
+            path_attrs += ToString(*style.line_cap);
+            path_attrs += '"';
+        }
+        if (style.line_join) {
+            path_attrs += " stroke-linejoin=\""sv;
+            path_attrs += ToString(*style.line_join);
+            path_attrs += '"';
+        }
+
+        std::string font_attrs;
+        if (!style.font_family.empty()) {
+            font_attrs += " font-family=\""sv;
+            font_attrs += style.font_family;
+            font_attrs += "\" "sv;
+        }
+        if (!style.font_weight.empty()) {
+            font_attrs += "font-weight=\""sv;
+            font_attrs += style.font_weight;
+            font_attrs += "\""sv;
+        }
+
+        styles_.push_back({ std::move(path_attrs), std::move(font_attrs) });
+        return it->second;
+    }
+
+    void Document::RenderObject(std::string& out, const CircleRecord& circle) const {
+        out += "<circle cx=\""sv;
+        AppendNumber(out, circle.center.x);
+        out += "\" cy=\""sv;
+        AppendNumber(out, circle.center.y);
+        out += "\" r=\""sv;
+        AppendNumber(out, circle.radius);
+        out += '"';
+        out += styles_[circle.style].path_attrs;
+        out += "/>"sv;
+    }
+
+    void Document::RenderObject(std::string& out, const PolylineRecord& polyline) const {
+        out += "<polyline points=\""sv;
+        for (size_t i = 0; i < polyline.point_count; ++i) {
+            if (i > 0) {
+                out += ' ';
+            }
+            AppendPoint(out, points_[polyline.first_point + i]);
+        }
+        out += '"';
+        out += styles_[polyline.style].path_attrs;
+        out += "/>"sv;
+    }
+
+    void Document::RenderObject(std::string& out, const TextRecord& text) const {
+        const StyleRecord& style = styles_[text.style];
+        out += "<text"sv;
+        out += style.path_attrs;
+        out += " x=\""sv;
+        AppendNumber(out, text.pos.x);
+        out += "\" y=\""sv;
+        AppendNumber(out, text.pos.y);
+        out += "\" dx=\""sv;
+        AppendNumber(out, text.offset.x);
+        out += "\" dy=\""sv;
+        AppendNumber(out, text.offset.y);
+        out += "\" font-size=\""sv;
+        AppendNumber(out, text.font_size);
+        out += '"';
+        out += style.font_attrs;
+        out += '>';
+        out.append(text_data_, text.data_begin, text.data_size);
+        out += "</text>"sv;
+    }
+
+    void Document::Render(std::string& out) const {
+        // Примерный размер: теги с оформлением, по координатной паре на точку
+        // и тексты надписей
+        out.reserve(out.size() + 128 + objects_.size() * 96 + points_.size() * 24 + text_data_.size());
+        out += "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv;
+        out += "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\""sv;
+        if (view_box_) {
+            out += " viewBox=\""sv;
+            AppendNumber(out, view_box_->origin.x);
+            out += ' ';
+            AppendNumber(out, view_box_->origin.y);
+            out += ' ';
+            AppendNumber(out, view_box_->width);
+            out += ' ';
+            AppendNumber(out, view_box_->height);
+            out += '"';
+        }
+        out += ">\n"sv;
+        for (const auto& object : objects_) {
+            out += "  "sv;
+            std::visit([this, &out](const auto& record) {
+                RenderObject(out, record);
+            }, object);
+            out += '\n';
+        }
+        out += "</svg>"sv;
+    }
+
+    void Document::Render(std::ostream& out) const {
+        std::string buffer;
+        Render(buffer);
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
     }
 
 }  // namespace svg
\ No newline at end of file
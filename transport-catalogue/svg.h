@@ -4,6 +4,8 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <optional>
 #include <variant>
@@ -42,27 +44,17 @@ namespace svg {
         double opacity;
     };
 
-    using Color = std::variant<std::monostate, std::string, Rgb, Rgba>;
+    inline bool operator==(const Rgb& lhs, const Rgb& rhs) {
+        return lhs.red == rhs.red && lhs.green == rhs.green && lhs.blue == rhs.blue;
+    }
 
-    inline const Color NoneColor{ std::monostate() };
+    inline bool operator==(const Rgba& lhs, const Rgba& rhs) {
+        return static_cast<const Rgb&>(lhs) == static_cast<const Rgb&>(rhs) && lhs.opacity == rhs.opacity;
+    }
 
-    std::ostream& operator<<(std::ostream& out, Color& color);
+    using Color = std::variant<std::monostate, std::string, Rgb, Rgba>;
 
-    struct ColorPrinter {
-        std::ostream& out;
-        void operator()(std::monostate) const { out << "none"; }
-        void operator()(std::string color) const { out << color; }
-        void operator()(Rgb color) const {
-            out << "rgb("
-                << static_cast<int>(color.red) << "," << static_cast<int>(color.green) << "," << static_cast<int>(color.blue)
-                << ")";
-        }
-        void operator()(Rgba color) const {
-            out << "rgba("
-                << static_cast<int>(color.red) << "," << static_cast<int>(color.green) << "," << static_cast<int>(color.blue) << "," << color.opacity
-                << ")";
-        }
-    };
+    inline const Color NoneColor{ std::monostate() };
 
     enum class StrokeLineCap {
         BUTT,
@@ -78,8 +70,8 @@ namespace svg {
         ROUND,
     };
 
-    std::ostream& operator<<(std::ostream& out, StrokeLineCap line_cap);
-    std::ostream& operator<<(std::ostream& out, StrokeLineJoin line_join);
+    std::string_view ToString(StrokeLineCap line_cap);
+    std::string_view ToString(StrokeLineJoin line_join);
 
     struct Point {
         Point() = default;
@@ -91,146 +83,98 @@ namespace svg {
         double y = 0;
     };
 
-    struct RenderContext {
-        RenderContext(std::ostream& out)
-            : out(out) {
-        }
-
-        RenderContext(std::ostream& out, int indent_step, int indent = 0)
-            : out(out)
-            , indent_step(indent_step)
-            , indent(indent) {
-        }
-
-        RenderContext Indented() const {
-            return { out, indent_step, indent + indent_step };
-        }
-
-        void RenderIndent() const {
-            for (int i = 0; i < indent; ++i) {
-                out.put(' ');
-            }
-        }
-
-        std::ostream& out;
-        int indent_step = 0;
-        int indent = 0;
+    // Оформление фигуры: атрибуты обводки и заливки, а для текста ещё и шрифт.
+    // Документ хранит каждое различное оформление один раз
+    struct Style {
+        std::optional<Color> fill_color;
+        std::optional<Color> stroke_color;
+        std::optional<double> width;
+        std::optional<StrokeLineCap> line_cap;
+        std::optional<StrokeLineJoin> line_join;
+        std::string font_family;
+        std::string font_weight;
+
+        bool operator==(const Style& rhs) const;
     };
 
-    class Object {
-    public:
-        void Render(const RenderContext& context) const;
-
-        virtual ~Object() = default;
-
-    private:
-        virtual void RenderObject(const RenderContext& context) const = 0;
-    };
-
-    class ObjectContainer {
-    public:
-        template <typename T>
-        void Add(T obj) {
-            AddPtr(std::make_unique<T>(std::move(obj)));
-        }
-
-        virtual void AddPtr(std::unique_ptr<Object>&& obj) = 0;
-
-    protected:
-        ~ObjectContainer() = default;
-    };
-
-    class Drawable {
-    public:
-        virtual ~Drawable() = default;
-        virtual void Draw(ObjectContainer& container) const = 0;
+    struct StyleHasher {
+        size_t operator()(const Style& style) const;
     };
 
     template <typename Owner>
     class PathProps {
     public:
         Owner& SetFillColor(Color color) {
-            fill_color_ = std::move(color);
+            style_.fill_color = std::move(color);
             return AsOwner();
         }
         Owner& SetStrokeColor(Color color) {
-            stroke_color_ = std::move(color);
+            style_.stroke_color = std::move(color);
             return AsOwner();
         }
         Owner& SetStrokeWidth(double width) {
-            width_ = std::move(width);
+            style_.width = width;
             return AsOwner();
         }
         Owner& SetStrokeLineCap(StrokeLineCap line_cap) {
-            line_cap_ = line_cap;
+            style_.line_cap = line_cap;
             return AsOwner();
         }
         Owner& SetStrokeLineJoin(StrokeLineJoin line_join) {
-            line_join_ = line_join;
+            style_.line_join = line_join;
             return AsOwner();
         }
 
+        const Style& GetStyle() const {
+            return style_;
+        }
+
     protected:
         ~PathProps() = default;
 
-        void RenderAttrs(std::ostream& out) const {
-            using namespace std::literals;
-
-            if (fill_color_) {
-                out << " fill=\""sv;
-                std::visit(ColorPrinter{ out }, *fill_color_);
-                out << "\""sv;
-            }
-            if (stroke_color_) {
-                out << " stroke=\""sv;
-                std::visit(ColorPrinter{ out }, *stroke_color_);
-                out << "\""sv;
-            }
-            if (width_) {
-                out << " stroke-width=\""sv << *width_ << "\""sv;
-            }
-            if (line_cap_) {
-                out << " stroke-linecap=\""sv << *line_cap_ << "\""sv;
-            }
-            if (line_join_) {
-                out << " stroke-linejoin=\""sv << *line_join_ << "\""sv;
-            }
-        }
+        Style style_;
 
     private:
         Owner& AsOwner() {
             return static_cast<Owner&>(*this);
         }
-
-        std::optional<Color> fill_color_;
-        std::optional<Color> stroke_color_;
-        std::optional<double> width_;
-        std::optional<StrokeLineCap> line_cap_;
-        std::optional<StrokeLineJoin> line_join_;
     };
 
-    class Circle final : public Object, public PathProps<Circle> {
+    // Фигуры - обычные значения: их настраивают и передают в Document::Add,
+    // а документ раскладывает их данные по своим массивам
+    class Circle final : public PathProps<Circle> {
     public:
         Circle& SetCenter(Point center);
         Circle& SetRadius(double radius);
 
-    private:
-        void RenderObject(const RenderContext& context) const override;
+        Point GetCenter() const {
+            return center_;
+        }
+        double GetRadius() const {
+            return radius_;
+        }
 
+    private:
         Point center_;
         double radius_ = 1.0;
     };
 
-    class Polyline final : public Object, public PathProps<Polyline> {
+    class Polyline final : public PathProps<Polyline> {
     public:
         Polyline& AddPoint(Point point);
 
+        const std::vector<Point>& GetPoints() const {
+            return points_;
+        }
+
     private:
-        void RenderObject(const RenderContext& context) const override;
+        // Документ забирает точки ломаной, добавляемой по rvalue
+        friend class Document;
+
         std::vector<Point> points_;
     };
 
-    class Text final : public Object, public PathProps<Text> {
+    class Text final : public PathProps<Text> {
     public:
         Text& SetPosition(Point pos);
 
@@ -244,26 +188,104 @@ namespace svg {
 
         Text& SetData(std::string data);
 
+        Point GetPosition() const {
+            return pos_;
+        }
+        Point GetOffset() const {
+            return offset_;
+        }
+        uint32_t GetFontSize() const {
+            return size_;
+        }
+        const std::string& GetData() const {
+            return data_;
+        }
+
     private:
-        void RenderObject(const RenderContext& context) const override;
+        friend class Document;
 
         Point pos_ = { 0.0, 0.0 };
         Point offset_ = { 0.0, 0.0 };
         uint32_t size_ = 1;
 
-        std::string font_family_;
-        std::string font_weight_;
         std::string data_;
     };
 
-    class Document : public ObjectContainer {
+    // Фигуры хранятся без отдельных выделений памяти: записи идут подряд в
+    // одном массиве в порядке добавления, точки ломаных и тексты надписей -
+    // в общих буферах, а оформление - ссылкой на общую запись, в которой
+    // атрибуты уже переведены в текст
+    class Document {
     public:
-        void AddPtr(std::unique_ptr<Object>&& obj) override;
-
+        void Add(const Circle& circle);
+        void Add(const Polyline& polyline);
+        void Add(const Text& text);
+        // Точки и текст переносятся в общие буферы документа; если буфер ещё
+        // пуст, он забирается у фигуры целиком
+        void Add(Polyline&& polyline);
+        void Add(Text&& text);
+
+        // Дописывает объекты other в конец документа в их порядке. Буферы
+        // склеиваются целиком, оформления сопоставляются по одному разу на
+        // каждое различное, а не на каждый объект
+        void Append(Document&& other);
+
+        // Видимая область в координатах документа. Так фрагмент растягивается
+        // на весь холст, сохраняя координаты объектов
+        void SetViewBox(Point origin, double width, double height);
+
+        // Дописывает текст документа в конец out. Числа форматируются так же,
+        // как при выводе в std::ostream, но без потоков и локалей
+        void Render(std::string& out) const;
         void Render(std::ostream& out) const;
 
     private:
-        std::vector<std::unique_ptr<Object>> objects_;
+        struct CircleRecord {
+            Point center;
+            double radius;
+            uint32_t style;
+        };
+
+        struct PolylineRecord {
+            size_t first_point;
+            size_t point_count;
+            uint32_t style;
+        };
+
+        struct TextRecord {
+            Point pos;
+            Point offset;
+            uint32_t font_size;
+            uint32_t style;
+            size_t data_begin;
+            size_t data_size;
+        };
+
+        struct ViewBox {
+            Point origin;
+            double width;
+            double height;
+        };
+
+        struct StyleRecord {
+            // Атрибуты обводки и заливки, как они выводятся в теге
+            std::string path_attrs;
+            // Атрибуты шрифта, выводимые после font-size
+            std::string font_attrs;
+        };
+
+        uint32_t InternStyle(const Style& style);
+
+        void RenderObject(std::string& out, const CircleRecord& circle) const;
+        void RenderObject(std::string& out, const PolylineRecord& polyline) const;
+        void RenderObject(std::string& out, const TextRecord& text) const;
+
+        std::vector<std::variant<CircleRecord, PolylineRecord, TextRecord>> objects_;
+        std::vector<Point> points_;
+        std::string text_data_;
+        std::vector<StyleRecord> styles_;
+        std::unordered_map<Style, uint32_t, StyleHasher> style_ids_;
+        std::optional<ViewBox> view_box_;
     };
 
 }  // namespace svg
\ No newline at end of file
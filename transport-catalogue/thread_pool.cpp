@@ -0,0 +1,60 @@
+#include "thread_pool.h"
+
+namespace parallel {
+
+    ThreadPool::ThreadPool(size_t thread_count) {
+        workers_.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; ++i) {
+            workers_.emplace_back([this] {
+                WorkerLoop();
+            });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard guard(mutex_);
+            stopping_ = true;
+        }
+        has_tasks_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::Submit(std::function<void()> task) {
+        {
+            std::lock_guard guard(mutex_);
+            tasks_.push(std::move(task));
+        }
+        has_tasks_.notify_one();
+    }
+
+    size_t ThreadPool::GetThreadCount() const {
+        return workers_.size();
+    }
+
+    void ThreadPool::WorkerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(mutex_);
+                has_tasks_.wait(lock, [this] {
+                    return stopping_ || !tasks_.empty();
+                });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+        }
+    }
+
+    ThreadPool& GetThreadPool() {
+        static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+        return pool;
+    }
+
+} // namespace parallel
\ No newline at end of file
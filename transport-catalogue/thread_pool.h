@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace parallel {
+
+    class ThreadPool {
+    public:
+        explicit ThreadPool(size_t thread_count);
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool();
+
+        void Submit(std::function<void()> task);
+        size_t GetThreadCount() const;
+
+    private:
+        void WorkerLoop();
+
+        std::vector<std::thread> workers_;
+        std::queue<std::function<void()>> tasks_;
+        std::mutex mutex_;
+        std::condition_variable has_tasks_;
+        bool stopping_ = false;
+    };
+
+    // Общий пул процесса по числу аппаратных потоков
+    ThreadPool& GetThreadPool();
+
+    // Делит [0, count) на непрерывные части и вызывает для каждой func(begin, end).
+    // Вызывающий поток тоже обрабатывает части, поэтому вложенный вызов из задачи
+    // пула не блокируется. Первое выброшенное исключение пробрасывается вызывающему
+    template <typename Func>
+    void ParallelFor(size_t count, Func&& func) {
+        ThreadPool& pool = GetThreadPool();
+        const size_t chunk_count = std::min(count, pool.GetThreadCount() * 4);
+        if (chunk_count <= 1) {
+            if (count > 0) {
+                func(size_t{ 0 }, count);
+            }
+            return;
+        }
+
+        struct State {
+            std::atomic<size_t> next_chunk{ 0 };
+            size_t done_chunks = 0;
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::condition_variable all_done;
+        };
+        auto state = std::make_shared<State>();
+
+        // Задача, взявшая часть после возврата из ParallelFor, невозможна:
+        // возврат происходит только когда все части уже обработаны
+        auto run_chunks = [state, &func, count, chunk_count] {
+            for (size_t chunk = state->next_chunk++; chunk < chunk_count; chunk = state->next_chunk++) {
+                std::exception_ptr error;
+                try {
+                    func(count * chunk / chunk_count, count * (chunk + 1) / chunk_count);
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+                std::lock_guard guard(state->mutex);
+                if (error && !state->error) {
+                    state->error = error;
+                }
+                if (++state->done_chunks == chunk_count) {
+                    state->all_done.notify_all();
+                }
+            }
+        };
+
+        const size_t helper_count = std::min(pool.GetThreadCount(), chunk_count - 1);
+        for (size_t i = 0; i < helper_count; ++i) {
+            pool.Submit(run_chunks);
+        }
+        run_chunks();
+
+        std::unique_lock lock(state->mutex);
+        state->all_done.wait(lock, [&state, chunk_count] {
+            return state->done_chunks == chunk_count;
+        });
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+    }
+
+    // Вычисляет produce(i) для всех i из [0, count) в пуле и передаёт результаты
+    // в consume(i, result) строго по порядку i в вызывающем потоке. Тяжёлый
+    // элемент задерживает только выдачу, а не вычисление следующих, но вперёд
+    // уходит не больше window элементов, чтобы не копить результаты в памяти.
+    // Вызывающий поток, пока ждёт очередной результат, сам берёт элементы,
+    // поэтому вложенный вызов из задачи пула не блокируется. Исключение из
+    // produce пробрасывается, когда до элемента доходит очередь выдачи
+    template <typename Produce, typename Consume>
+    void ParallelForOrdered(size_t count, size_t window, Produce&& produce, Consume&& consume) {
+        using Result = std::invoke_result_t<Produce&, size_t>;
+
+        ThreadPool& pool = GetThreadPool();
+        const size_t helper_count = std::min(pool.GetThreadCount(), count > 0 ? count - 1 : 0);
+        if (helper_count == 0 || window <= 1) {
+            for (size_t i = 0; i < count; ++i) {
+                consume(i, produce(i));
+            }
+            return;
+        }
+
+        struct Slot {
+            std::optional<Result> result;
+            std::exception_ptr error;
+        };
+        struct State {
+            explicit State(size_t window)
+                : slots(window) {
+            }
+
+            std::vector<Slot> slots;
+            size_t next_index = 0;
+            size_t consumed = 0;
+            // Элементы, взятые в работу, но ещё не положенные в слот
+            size_t in_flight = 0;
+            bool stopping = false;
+            std::mutex mutex;
+            std::condition_variable changed;
+        };
+        auto state = std::make_shared<State>(window);
+
+        // Берёт элемент под захваченным мьютексом, вычисляет его без мьютекса
+        // и кладёт результат в слот
+        auto run_one = [state, &produce, window](std::unique_lock<std::mutex>& lock) {
+            const size_t index = state->next_index++;
+            ++state->in_flight;
+            lock.unlock();
+            Slot slot;
+            try {
+                slot.result.emplace(produce(index));
+            }
+            catch (...) {
+                slot.error = std::current_exception();
+            }
+            lock.lock();
+            state->slots[index % window] = std::move(slot);
+            --state->in_flight;
+            state->changed.notify_all();
+        };
+        auto can_take = [state, count, window] {
+            return !state->stopping && state->next_index < count
+                && state->next_index < state->consumed + window;
+        };
+
+        // Задача, начавшая работу после выхода из функции, не вызовет produce:
+        // к этому моменту stopping уже выставлен
+        for (size_t i = 0; i < helper_count; ++i) {
+            pool.Submit([state, run_one, can_take, count] {
+                std::unique_lock lock(state->mutex);
+                while (true) {
+                    state->changed.wait(lock, [&] {
+                        return can_take() || state->stopping || state->next_index >= count;
+                    });
+                    if (!can_take()) {
+                        return;
+                    }
+                    run_one(lock);
+                }
+            });
+        }
+
+        std::exception_ptr error;
+        {
+            std::unique_lock lock(state->mutex);
+            while (state->consumed < count) {
+                Slot& slot = state->slots[state->consumed % window];
+                if (slot.error) {
+                    error = slot.error;
+                    break;
+                }
+                if (slot.result) {
+                    Result result = std::move(*slot.result);
+                    slot.result.reset();
+                    lock.unlock();
+                    try {
+                        consume(state->consumed, std::move(result));
+                    }
+                    catch (...) {
+                        lock.lock();
+                        error = std::current_exception();
+                        break;
+                    }
+                    lock.lock();
+                    ++state->consumed;
+                    state->changed.notify_all();
+                }
+                else if (can_take()) {
+                    run_one(lock);
+                }
+                else {
+                    state->changed.wait(lock);
+                }
+            }
+
+            // Элементы, уже взятые в работу, ссылаются на produce
+            state->stopping = true;
+            state->changed.notify_all();
+            state->changed.wait(lock, [&state] {
+                return state->in_flight == 0;
+            });
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+} // namespace parallel
\ No newline at end of file
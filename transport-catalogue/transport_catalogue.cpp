@@ -3,20 +3,35 @@
 namespace transport_catalogue {
 
     void TransportCatalogue::AddStop(std::string_view stop_name, const geo::Coordinates coordinates) {
-        all_stops_.push_back({ std::string(stop_name), coordinates, {} });
+        ++version_;
+        all_stops_.push_back({ static_cast<StopId>(all_stops_.size()), names_.Intern(stop_name), coordinates });
         stopname_to_stop_[all_stops_.back().name] = &all_stops_.back();
+        stop_buses_.emplace_back();
     }
 
     void TransportCatalogue::AddRoute(std::string_view bus_number, const std::vector<const Stop*> stops, bool is_circle) {
-        all_buses_.push_back({ std::string(bus_number), stops, is_circle });
-        busname_to_bus_[all_buses_.back().number] = &all_buses_.back();
+        ++version_;
+        all_buses_.push_back({ static_cast<BusId>(all_buses_.size()), names_.Intern(bus_number), stops, is_circle, {}, {}, std::nullopt });
+        UpdateRouteDistances(all_buses_.back());
+        const Bus& bus = all_buses_.back();
+        busname_to_bus_[bus.number] = &bus;
+
+        const auto is_number_less = [this](BusId lhs, BusId rhs) {
+            return all_buses_[lhs].number < all_buses_[rhs].number;
+        };
         for (const auto& route_stop : stops) {
-            for (auto& stop_ : all_stops_) {
-                if (stop_.name == route_stop->name) stop_.buses_by_stop.insert(std::string(bus_number));
+            auto& stop_buses = stop_buses_[route_stop->id];
+            auto it = std::lower_bound(stop_buses.begin(), stop_buses.end(), bus.id, is_number_less);
+            if (it == stop_buses.end() || *it != bus.id) {
+                stop_buses.insert(it, bus.id);
             }
         }
     }
 
+    const std::vector<BusId>& TransportCatalogue::GetStopBuses(StopId stop_id) const {
+        return stop_buses_.at(stop_id);
+    }
+
     const Bus* TransportCatalogue::FindRoute(std::string_view bus_number) const {
         return busname_to_bus_.count(bus_number) ? busname_to_bus_.at(bus_number) : nullptr;
     }
@@ -25,30 +40,96 @@ namespace transport_catalogue {
         return stopname_to_stop_.count(stop_name) ? stopname_to_stop_.at(stop_name) : nullptr;
     }
 
-    size_t TransportCatalogue::GetUniqueStopsCount(std::string_view bus_number) const {
-        std::unordered_set<std::string_view> unique_stops;
-        for (const auto& stop : busname_to_bus_.at(bus_number)->stops) {
-            unique_stops.insert(stop->name);
+    const Bus* TransportCatalogue::GetBus(BusId bus_id) const {
+        return &all_buses_.at(bus_id);
+    }
+
+    const Stop* TransportCatalogue::GetStop(StopId stop_id) const {
+        return &all_stops_.at(stop_id);
+    }
+
+    size_t TransportCatalogue::GetBusesCount() const {
+        return all_buses_.size();
+    }
+
+    size_t TransportCatalogue::GetStopsCount() const {
+        return all_stops_.size();
+    }
+
+    size_t TransportCatalogue::GetUniqueStopsCount(const Bus* bus) const {
+        std::vector<StopId> unique_stops;
+        unique_stops.reserve(bus->stops.size());
+        for (const auto& stop : bus->stops) {
+            unique_stops.push_back(stop->id);
         }
-        return unique_stops.size();
+        std::sort(unique_stops.begin(), unique_stops.end());
+        return std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin();
     }
 
     void TransportCatalogue::SetDistance(const Stop* from, const Stop* to, const int distance) {
-        stop_distances_[{from, to}] = distance;
+        if (!from || !to) {
+            throw std::invalid_argument("Unknown stop in road distance");
+        }
+        ++version_;
+        stop_distances_.Set(from->id, to->id, distance);
+
+        // Расстояние, заданное после маршрутов, меняет их префиксные суммы
+        for (const StopId stop_id : { from->id, to->id }) {
+            for (const BusId bus_id : stop_buses_[stop_id]) {
+                UpdateRouteDistances(all_buses_[bus_id]);
+            }
+        }
     }
 
-    int TransportCatalogue::GetDistance(const Stop* from, const Stop* to) const {
-        if (stop_distances_.count({ from, to })) {
-            return stop_distances_.at({ from, to });
+    void TransportCatalogue::SetDistances(const std::vector<StopDistance>& distances) {
+        for (const StopDistance& entry : distances) {
+            if (!entry.from || !entry.to) {
+                throw std::invalid_argument("Unknown stop in road distance");
+            }
         }
-        else if (stop_distances_.count({ to, from })) {
-            return stop_distances_.at({ to, from });
+        ++version_;
+        std::vector<StopDistanceTable::Entry> entries;
+        entries.reserve(distances.size());
+        std::vector<bool> is_bus_affected(all_buses_.size(), false);
+        for (const auto& [from, to, distance] : distances) {
+            entries.push_back({ from->id, to->id, distance });
+            for (const StopId stop_id : { from->id, to->id }) {
+                for (const BusId bus_id : stop_buses_[stop_id]) {
+                    is_bus_affected[bus_id] = true;
+                }
+            }
         }
-        else {
-            return 0;
+        stop_distances_.SetBulk(entries);
+
+        for (BusId bus_id = 0; bus_id < all_buses_.size(); ++bus_id) {
+            if (is_bus_affected[bus_id]) {
+                UpdateRouteDistances(all_buses_[bus_id]);
+            }
         }
     }
 
+    void TransportCatalogue::UpdateRouteDistances(Bus& bus) const {
+        const auto& stops = bus.stops;
+        bus.stat.reset();
+        bus.forward_distances.assign(stops.size(), 0);
+        bus.backward_distances.assign(stops.size(), 0);
+        for (size_t i = 1; i < stops.size(); ++i) {
+            bus.forward_distances[i] = bus.forward_distances[i - 1] + GetDistance(stops[i - 1], stops[i]);
+            bus.backward_distances[i] = bus.backward_distances[i - 1] + GetDistance(stops[i], stops[i - 1]);
+        }
+    }
+
+    int TransportCatalogue::GetRouteDistance(const Bus* bus, size_t from_index, size_t to_index) const {
+        if (from_index <= to_index) {
+            return bus->forward_distances[to_index] - bus->forward_distances[from_index];
+        }
+        return bus->backward_distances[from_index] - bus->backward_distances[to_index];
+    }
+
+    int TransportCatalogue::GetDistance(const Stop* from, const Stop* to) const {
+        return stop_distances_.Get(from->id, to->id);
+    }
+
     const std::map<std::string_view, const Bus*> TransportCatalogue::GetBusesOnStop() const {
         std::map<std::string_view, const Bus*> result;
         for (const auto& bus : busname_to_bus_) {
@@ -65,6 +146,25 @@ namespace transport_catalogue {
         return result;
     }
 
+    void TransportCatalogue::PrecomputeBusStats() {
+        parallel::ParallelFor(all_buses_.size(), [this](size_t begin, size_t end) {
+            for (size_t bus_id = begin; bus_id < end; ++bus_id) {
+                Bus& bus = all_buses_[bus_id];
+                if (!bus.stat && !bus.stops.empty()) {
+                    bus.stat = CalculateBusStat(&bus);
+                }
+            }
+        });
+    }
+
+    BusStat TransportCatalogue::GetBusStat(const Bus* bus) const {
+        return bus->stat ? *bus->stat : CalculateBusStat(bus);
+    }
+
+    uint64_t TransportCatalogue::GetVersion() const {
+        return version_;
+    }
+
     BusStat TransportCatalogue::CalculateBusStat(const Bus* bus) const {
         BusStat bus_stat{};
 
@@ -75,25 +175,27 @@ namespace transport_catalogue {
             bus_stat.stops_count = bus->stops.size() * 2 - 1;
         }
 
-        int route_length = 0;
-        double geographic_length = 0.0;
+        const size_t last_index = bus->stops.size() - 1;
+        int route_length = GetRouteDistance(bus, 0, last_index);
+        if (!bus->is_circle) {
+            route_length += GetRouteDistance(bus, last_index, 0);
+        }
 
-        for (size_t i = 0; i < bus->stops.size() - 1; ++i) {
+        double geographic_length = 0.0;
+        for (size_t i = 0; i < last_index; ++i) {
             auto from = bus->stops[i];
             auto to = bus->stops[i + 1];
             if (bus->is_circle) {
-                route_length += this->GetDistance(from, to);
                 geographic_length += geo::ComputeDistance(from->coordinates,
                     to->coordinates);
             }
             else {
-                route_length += this->GetDistance(from, to) + this->GetDistance(to, from);
                 geographic_length += geo::ComputeDistance(from->coordinates,
                     to->coordinates) * 2;
             }
         }
 
-        bus_stat.unique_stops_count = this->GetUniqueStopsCount(bus->number);
+        bus_stat.unique_stops_count = this->GetUniqueStopsCount(bus);
         bus_stat.route_length = route_length;
         bus_stat.curvature = route_length / geographic_length;
 
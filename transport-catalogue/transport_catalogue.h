@@ -2,7 +2,12 @@
 
 #include "geo.h"
 #include "domain.h"
+#include "stop_distance_table.h"
+#include "string_pool.h"
+#include "thread_pool.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <deque>
 #include <string>
@@ -18,38 +23,61 @@ namespace transport_catalogue {
 
     class TransportCatalogue {
     public:
-        struct StopDistancesHasher {
-            size_t operator()(const std::pair<const Stop*, const Stop*>& points) const {
-                size_t hash_first = std::hash<const void*>{}(points.first);
-                size_t hash_second = std::hash<const void*>{}(points.second);
-                return hash_first + hash_second * 37;
-            }
-        };
-
         void AddRoute(std::string_view bus_number, const std::vector<const Stop*> stops, bool is_circle);
         void AddStop(std::string_view stop_name, const geo::Coordinates coordinates);
 
         const Bus* FindRoute(std::string_view bus_number) const;
         const Stop* FindStop(std::string_view stop_name) const;
 
+        // Автобусы, проходящие через остановку, упорядоченные по номеру
+        const std::vector<BusId>& GetStopBuses(StopId stop_id) const;
+
+        const Bus* GetBus(BusId bus_id) const;
+        const Stop* GetStop(StopId stop_id) const;
+        size_t GetBusesCount() const;
+        size_t GetStopsCount() const;
+
         const std::map<std::string_view, const Bus*> GetBusesOnStop() const;
         const std::map<std::string_view, const Stop*> GetAllStops() const;
 
+        // Обе остановки должны быть в справочнике, иначе std::invalid_argument
         void SetDistance(const Stop* from, const Stop* to, const int distance);
+        // Массовая загрузка расстояний: таблица резервируется один раз, а
+        // префиксные суммы затронутых маршрутов пересчитываются однократно.
+        // При неизвестной остановке справочник не меняется
+        void SetDistances(const std::vector<StopDistance>& distances);
         int GetDistance(const Stop* from, const Stop* to) const;
+        // Дорожное расстояние по маршруту от остановки с индексом from_index до
+        // остановки to_index; при from_index > to_index - в обратном направлении
+        int GetRouteDistance(const Bus* bus, size_t from_index, size_t to_index) const;
 
         BusStat CalculateBusStat(const Bus* bus) const;
+        // Считает статистику всех маршрутов параллельно; вызывается после загрузки
+        void PrecomputeBusStats();
+        // Сохранённая статистика маршрута, а если её нет - вычисленная заново
+        BusStat GetBusStat(const Bus* bus) const;
+
+        // Растёт при каждом изменении остановок, маршрутов и расстояний;
+        // по ней сбрасываются кэши, построенные по данным каталога
+        uint64_t GetVersion() const;
 
     private:
-        size_t GetUniqueStopsCount(std::string_view bus_number) const;
+        size_t GetUniqueStopsCount(const Bus* bus) const;
+        void UpdateRouteDistances(Bus& bus) const;
 
+        StringPool names_;
         std::deque<Bus> all_buses_;
         std::deque<Stop> all_stops_;
 
         std::unordered_map<std::string_view, const Bus*> busname_to_bus_;
         std::unordered_map<std::string_view, const Stop*> stopname_to_stop_;
 
-        std::unordered_map<std::pair<const Stop*, const Stop*>, int, StopDistancesHasher> stop_distances_;
+        // Обратный индекс остановка -> автобусы, по StopId
+        std::vector<std::vector<BusId>> stop_buses_;
+
+        StopDistanceTable stop_distances_;
+
+        uint64_t version_ = 0;
     };
 
 } // namespace transport_catalogue
\ No newline at end of file
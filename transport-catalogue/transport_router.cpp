@@ -2,72 +2,192 @@
 
 namespace transport_catalogue {
 
-    const graph::DirectedWeightedGraph<double>& Router::BuildGraph(const TransportCatalogue& catalogue) {
+    double Router::GetRideTime(int distance) const {
+        return static_cast<double>(distance) / (bus_velocity_ * (100.0 / 6.0));
+    }
+
+    void Router::BuildStopPairsGraph(const TransportCatalogue& catalogue) {
         const auto& all_stops = catalogue.GetAllStops();
         const auto& all_buses = catalogue.GetBusesOnStop();
         graph::DirectedWeightedGraph<double> stops_graph(all_stops.size() * 2);
-        std::map<std::string, graph::VertexId> stop_ids;
+        std::vector<graph::VertexId> stop_vertices(catalogue.GetStopsCount());
+        std::vector<RouteEdgeInfo> edge_infos;
         graph::VertexId vertex_id = 0;
 
         for (const auto& [stop_name, stop_info] : all_stops) {
-            stop_ids[stop_info->name] = vertex_id;
+            stop_vertices[stop_info->id] = vertex_id;
             stops_graph.AddEdge({
-                    stop_info->name,
-                    0,
                     vertex_id,
                     ++vertex_id,
                     static_cast<double>(bus_wait_time_)
                 });
+            edge_infos.push_back({ RouteEdgeType::WAIT, stop_info->name, 0 });
             ++vertex_id;
         }
-        stop_ids_ = std::move(stop_ids);
+        stop_vertices_ = std::move(stop_vertices);
+
+        // Рёбра каждого автобуса занимают заранее вычисленный диапазон, поэтому
+        // их можно генерировать параллельно, сохраняя порядок EdgeId
+        std::vector<const Bus*> buses;
+        std::vector<size_t> edge_offsets{ edge_infos.size() };
+        buses.reserve(all_buses.size());
+        for (const auto& [bus_number, bus_info] : all_buses) {
+            const size_t stops_count = bus_info->stops.size();
+            const size_t pairs_count = stops_count > 1 ? stops_count * (stops_count - 1) / 2 : 0;
+            buses.push_back(bus_info);
+            edge_offsets.push_back(edge_offsets.back() + pairs_count * (bus_info->is_circle ? 1 : 2));
+        }
+
+        std::vector<graph::Edge<double>> bus_edges(edge_offsets.back() - edge_offsets.front());
+        edge_infos.resize(edge_offsets.back());
 
-        std::for_each(
-            all_buses.begin(),
-            all_buses.end(),
-            [&stops_graph, this, &catalogue](const auto& item) {
-                const auto& bus_info = item.second;
+        parallel::ParallelFor(buses.size(), [&](size_t begin, size_t end) {
+            for (size_t bus_index = begin; bus_index < end; ++bus_index) {
+                const Bus* bus_info = buses[bus_index];
                 const auto& stops = bus_info->stops;
-                size_t stops_count = stops.size();
+                const size_t stops_count = stops.size();
+
+                size_t edge_index = edge_offsets[bus_index];
                 for (size_t i = 0; i < stops_count; ++i) {
                     for (size_t j = i + 1; j < stops_count; ++j) {
-                        const Stop* stop_from = stops[i];
-                        const Stop* stop_to = stops[j];
-                        int dist_sum = 0;
-                        int dist_sum_inverse = 0;
-                        for (size_t k = i + 1; k <= j; ++k) {
-                            dist_sum += catalogue.GetDistance(stops[k - 1], stops[k]);
-                            dist_sum_inverse += catalogue.GetDistance(stops[k], stops[k - 1]);
-                        }
-                        stops_graph.AddEdge({ bus_info->number,
-                                              j - i,
-                                              stop_ids_.at(stop_from->name) + 1,
-                                              stop_ids_.at(stop_to->name),
-                                              static_cast<double>(dist_sum) / (bus_velocity_ * (100.0 / 6.0)) });
+                        bus_edges[edge_index - edge_offsets.front()] = { stop_vertices_[stops[i]->id] + 1,
+                                                                         stop_vertices_[stops[j]->id],
+                                                                         GetRideTime(catalogue.GetRouteDistance(bus_info, i, j)) };
+                        edge_infos[edge_index++] = { RouteEdgeType::BUS, bus_info->number, j - i };
 
                         if (!bus_info->is_circle) {
-                            stops_graph.AddEdge({ bus_info->number,
-                                                  j - i,
-                                                  stop_ids_.at(stop_to->name) + 1,
-                                                  stop_ids_.at(stop_from->name),
-                                                  static_cast<double>(dist_sum_inverse) / (bus_velocity_ * (100.0 / 6.0)) });
+                            bus_edges[edge_index - edge_offsets.front()] = { stop_vertices_[stops[j]->id] + 1,
+                                                                             stop_vertices_[stops[i]->id],
+                                                                             GetRideTime(catalogue.GetRouteDistance(bus_info, j, i)) };
+                            edge_infos[edge_index++] = { RouteEdgeType::BUS, bus_info->number, j - i };
                         }
                     }
                 }
-            });
+            }
+        });
+
+        for (const auto& edge : bus_edges) {
+            stops_graph.AddEdge(edge);
+        }
 
         graph_ = std::move(stops_graph);
-        router_ = std::make_unique<graph::Router<double>>(graph_);
+        edge_infos_ = std::move(edge_infos);
+    }
+
+    void Router::BuildRouteNodesGraph(const TransportCatalogue& catalogue) {
+        const auto& all_stops = catalogue.GetAllStops();
+        const auto& all_buses = catalogue.GetBusesOnStop();
+
+        // Некольцевой маршрут проходится в обе стороны как два отдельных направления
+        size_t vertex_count = all_stops.size();
+        for (const auto& [bus_number, bus_info] : all_buses) {
+            vertex_count += bus_info->stops.size() * (bus_info->is_circle ? 1 : 2);
+        }
+
+        graph::DirectedWeightedGraph<double> route_graph(vertex_count);
+        std::vector<graph::VertexId> stop_vertices(catalogue.GetStopsCount());
+        std::vector<RouteEdgeInfo> edge_infos;
+        graph::VertexId vertex_id = 0;
+
+        for (const auto& [stop_name, stop_info] : all_stops) {
+            stop_vertices[stop_info->id] = vertex_id++;
+        }
+        stop_vertices_ = std::move(stop_vertices);
+
+        // Вершина каждой остановки направления связана с вершиной самой остановки
+        // рёбрами посадки (с ожиданием) и высадки, а с соседней остановкой - ребром поездки
+        const auto add_direction = [&](const Bus* bus_info, auto stops_begin, auto stops_end) {
+            const graph::VertexId first_vertex = vertex_id;
+            for (auto it = stops_begin; it != stops_end; ++it) {
+                const Stop* stop = *it;
+                const graph::VertexId stop_vertex = stop_vertices_[stop->id];
+
+                route_graph.AddEdge({ stop_vertex, vertex_id, static_cast<double>(bus_wait_time_) });
+                edge_infos.push_back({ RouteEdgeType::WAIT, stop->name, 0 });
+                route_graph.AddEdge({ vertex_id, stop_vertex, 0.0 });
+                edge_infos.push_back({ RouteEdgeType::ALIGHT, stop->name, 0 });
+
+                if (vertex_id != first_vertex) {
+                    const Stop* prev_stop = *std::prev(it);
+                    route_graph.AddEdge({ vertex_id - 1, vertex_id, GetRideTime(catalogue.GetDistance(prev_stop, stop)) });
+                    edge_infos.push_back({ RouteEdgeType::BUS, bus_info->number, 1 });
+                }
+                ++vertex_id;
+            }
+        };
+
+        for (const auto& [bus_number, bus_info] : all_buses) {
+            const auto& stops = bus_info->stops;
+            add_direction(bus_info, stops.begin(), stops.end());
+            if (!bus_info->is_circle) {
+                add_direction(bus_info, stops.rbegin(), stops.rend());
+            }
+        }
+
+        graph_ = std::move(route_graph);
+        edge_infos_ = std::move(edge_infos);
+    }
+
+    const graph::DirectedWeightedGraph<double>& Router::BuildGraph(const TransportCatalogue& catalogue) {
+        if (graph_model_ == GraphModel::ROUTE_NODES) {
+            BuildRouteNodesGraph(catalogue);
+        }
+        else {
+            BuildStopPairsGraph(catalogue);
+        }
+
+        graph_.Freeze();
+        switch (router_type_) {
+        case RouterType::DIJKSTRA:
+            router_ = std::make_unique<graph::DijkstraRouter<double>>(graph_, tree_cache_budget_);
+            break;
+        case RouterType::CONTRACTION_HIERARCHY:
+            router_ = std::make_unique<graph::ContractionHierarchyRouter<double>>(graph_);
+            break;
+        case RouterType::ALL_PAIRS:
+            router_ = std::make_unique<graph::Router<double>>(graph_);
+            break;
+        }
 
         return graph_;
     }
 
-    const std::optional<graph::Router<double>::RouteInfo> Router::FindRoute(const std::string_view stop_from, const std::string_view stop_to) const {
-        return router_->BuildRoute(stop_ids_.at(std::string(stop_from)), stop_ids_.at(std::string(stop_to)));
+    const std::optional<RouteInfo> Router::FindRoute(const StopId stop_from, const StopId stop_to) const {
+        const auto route = router_->BuildRoute(stop_vertices_.at(stop_from), stop_vertices_.at(stop_to));
+        if (!route) {
+            return std::nullopt;
+        }
+
+        // Идущие подряд рёбра поездки (в модели ROUTE_NODES - перегоны одного
+        // направления) сливаются в один элемент, рёбра высадки не выводятся
+        RouteInfo result{ 0.0, {} };
+        result.items.reserve(route->edges.size());
+        RouteEdgeType prev_type = RouteEdgeType::WAIT;
+        for (const graph::EdgeId edge_id : route->edges) {
+            const RouteEdgeInfo& edge_info = edge_infos_.at(edge_id);
+            const double time = graph_.GetEdge(edge_id).weight;
+            if (edge_info.type == RouteEdgeType::BUS && prev_type == RouteEdgeType::BUS) {
+                result.items.back().span_count += edge_info.span_count;
+                result.items.back().time += time;
+            }
+            else if (edge_info.type != RouteEdgeType::ALIGHT) {
+                result.items.push_back({ edge_info.name, edge_info.span_count, time });
+            }
+            prev_type = edge_info.type;
+        }
+        for (const RouteItem& item : result.items) {
+            result.total_time += item.time;
+        }
+
+        return result;
     }
 
     const graph::DirectedWeightedGraph<double>& Router::GetGraph() const {
         return graph_;
     }
 
+    const RouteEdgeInfo& Router::GetEdgeInfo(graph::EdgeId edge_id) const {
+        return edge_infos_.at(edge_id);
+    }
+
 }
\ No newline at end of file
@@ -1,37 +1,102 @@
 #pragma once
 
 #include "router.h"
+#include "dijkstra_router.h"
+#include "contraction_hierarchy.h"
 #include "transport_catalogue.h"
+#include "thread_pool.h"
 
 #include <memory>
 
 namespace transport_catalogue {
 
+	// ALL_PAIRS - предподсчёт всех пар вершин, DIJKSTRA - поиск по запросу,
+	// CONTRACTION_HIERARCHY - предобработка иерархий сжатия и двунаправленный поиск
+	enum class RouterType {
+		ALL_PAIRS,
+		DIJKSTRA,
+		CONTRACTION_HIERARCHY,
+	};
+
+	// STOP_PAIRS - по ребру на каждую пару остановок маршрута (O(k^2) рёбер),
+	// ROUTE_NODES - вершина на каждую остановку каждого маршрута, рёбра поездки
+	// только между соседними остановками, посадка и высадка - отдельные рёбра
+	enum class GraphModel {
+		STOP_PAIRS,
+		ROUTE_NODES,
+	};
+
+	enum class RouteEdgeType {
+		WAIT,
+		BUS,
+		ALIGHT,
+	};
+
+	// Сведения о ребре графа маршрутов для ответа на запрос. Ребро ожидания
+	// несёт название остановки, ребро поездки - номер автобуса
+	struct RouteEdgeInfo {
+		RouteEdgeType type;
+		std::string_view name;
+		size_t span_count;
+	};
+
+	// Элемент ответа: ожидание на остановке (span_count == 0) или поездка
+	struct RouteItem {
+		std::string_view name;
+		size_t span_count;
+		double time;
+	};
+
+	struct RouteInfo {
+		double total_time;
+		std::vector<RouteItem> items;
+	};
+
 	class Router {
 	public:
 		Router() = default;
 
-		Router(const int bus_wait_time, const double bus_velocity)
+		// tree_cache_budget - объём памяти в байтах под кэш деревьев кратчайших путей
+		// движка DIJKSTRA; 0 отключает кэширование
+		Router(const int bus_wait_time, const double bus_velocity, const RouterType router_type = RouterType::ALL_PAIRS,
+			const size_t tree_cache_budget = 0, const GraphModel graph_model = GraphModel::STOP_PAIRS)
 			: bus_wait_time_(bus_wait_time)
-			, bus_velocity_(bus_velocity) {}
+			, bus_velocity_(bus_velocity)
+			, router_type_(router_type)
+			, tree_cache_budget_(tree_cache_budget)
+			, graph_model_(graph_model) {}
 
 		Router(const Router& settings, const TransportCatalogue& catalogue) {
 			bus_wait_time_ = settings.bus_wait_time_;
 			bus_velocity_ = settings.bus_velocity_;
+			router_type_ = settings.router_type_;
+			tree_cache_budget_ = settings.tree_cache_budget_;
+			graph_model_ = settings.graph_model_;
 			BuildGraph(catalogue);
 		}
 
 		const graph::DirectedWeightedGraph<double>& BuildGraph(const TransportCatalogue& catalogue);
-		const std::optional<graph::Router<double>::RouteInfo> FindRoute(const std::string_view stop_from, const std::string_view stop_to) const;
+		const std::optional<RouteInfo> FindRoute(const StopId stop_from, const StopId stop_to) const;
 		const graph::DirectedWeightedGraph<double>& GetGraph() const;
+		const RouteEdgeInfo& GetEdgeInfo(graph::EdgeId edge_id) const;
 
 	private:
+		double GetRideTime(int distance) const;
+		void BuildStopPairsGraph(const TransportCatalogue& catalogue);
+		void BuildRouteNodesGraph(const TransportCatalogue& catalogue);
+
 		int bus_wait_time_ = 0;
 		double bus_velocity_ = 0.0;
+		RouterType router_type_ = RouterType::ALL_PAIRS;
+		size_t tree_cache_budget_ = 0;
+		GraphModel graph_model_ = GraphModel::STOP_PAIRS;
 
 		graph::DirectedWeightedGraph<double> graph_;
-		std::map<std::string, graph::VertexId> stop_ids_;
-		std::unique_ptr<graph::Router<double>> router_;
+		std::vector<RouteEdgeInfo> edge_infos_;
+		// Вершина графа, из которой начинается и в которой заканчивается
+		// маршрут, для каждой остановки по её StopId
+		std::vector<graph::VertexId> stop_vertices_;
+		std::unique_ptr<graph::RouterBase<double>> router_;
 	};
 
 }
\ No newline at end of file
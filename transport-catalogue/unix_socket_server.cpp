@@ -0,0 +1,352 @@
+#include "unix_socket_server.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace server {
+
+    namespace {
+
+        // Обработчик сигнала может сработать в любом потоке процесса, поэтому
+        // о сигнале сообщается записью в канал, который слушает цикл событий
+        int stop_pipe_write_fd = -1;
+
+        void HandleStopSignal(int) {
+            const int saved_errno = errno;
+            const char byte = 0;
+            [[maybe_unused]] const auto result = write(stop_pipe_write_fd, &byte, 1);
+            errno = saved_errno;
+        }
+
+        [[noreturn]] void ThrowSystemError(const char* what) {
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+
+        void AddToEpoll(int epoll_fd, int fd, uint32_t events) {
+            epoll_event event{};
+            event.events = events;
+            event.data.fd = fd;
+            if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+                ThrowSystemError("epoll_ctl");
+            }
+        }
+
+    }  // namespace
+
+    UnixSocketServer::UnixSocketServer(std::string socket_path, LineHandler handler)
+        : socket_path_(std::move(socket_path))
+        , handler_(std::move(handler)) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socket_path_.empty() || socket_path_.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("Invalid socket path: " + socket_path_);
+        }
+        std::memcpy(address.sun_path, socket_path_.c_str(), socket_path_.size() + 1);
+
+        // Сокет, оставшийся от прежнего запуска, мешает bind
+        struct stat file_info {};
+        if (stat(socket_path_.c_str(), &file_info) == 0 && S_ISSOCK(file_info.st_mode)) {
+            unlink(socket_path_.c_str());
+        }
+
+        listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_fd_ < 0) {
+            ThrowSystemError("socket");
+        }
+        // Деструктор для недостроенного объекта не вызывается
+        auto fail = [this](const char* what, bool bound) {
+            const int saved_errno = errno;
+            if (epoll_fd_ >= 0) {
+                close(epoll_fd_);
+            }
+            close(listen_fd_);
+            if (bound) {
+                unlink(socket_path_.c_str());
+            }
+            errno = saved_errno;
+            ThrowSystemError(what);
+        };
+        if (bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+            fail("bind", false);
+        }
+        if (listen(listen_fd_, SOMAXCONN) < 0) {
+            fail("listen", true);
+        }
+
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            fail("epoll_create1", true);
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = listen_fd_;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event) < 0) {
+            fail("epoll_ctl", true);
+        }
+    }
+
+    UnixSocketServer::~UnixSocketServer() {
+        for (const auto& [fd, connection] : connections_) {
+            close(fd);
+        }
+        if (epoll_fd_ >= 0) {
+            close(epoll_fd_);
+        }
+        if (listen_fd_ >= 0) {
+            close(listen_fd_);
+            unlink(socket_path_.c_str());
+        }
+    }
+
+    void UnixSocketServer::Run() {
+        int stop_pipe[2];
+        if (pipe2(stop_pipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+            ThrowSystemError("pipe2");
+        }
+        stop_pipe_write_fd = stop_pipe[1];
+        AddToEpoll(epoll_fd_, stop_pipe[0], EPOLLIN);
+
+        struct sigaction action {};
+        action.sa_handler = HandleStopSignal;
+        sigemptyset(&action.sa_mask);
+        struct sigaction old_int {}, old_term {};
+        sigaction(SIGINT, &action, &old_int);
+        sigaction(SIGTERM, &action, &old_term);
+
+        constexpr int MAX_EVENTS = 64;
+        epoll_event events[MAX_EVENTS];
+        bool stopping = false;
+        while (!stopping) {
+            int timeout = -1;
+            if (!accepting_) {
+                const auto now = std::chrono::steady_clock::now();
+                if (now >= accept_retry_at_) {
+                    SetAccepting(true);
+                }
+                else {
+                    timeout = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(accept_retry_at_ - now).count());
+                }
+            }
+            const int count = epoll_wait(epoll_fd_, events, MAX_EVENTS, timeout);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ThrowSystemError("epoll_wait");
+            }
+
+            for (int i = 0; i < count; ++i) {
+                const int fd = events[i].data.fd;
+                if (fd == stop_pipe[0]) {
+                    stopping = true;
+                    continue;
+                }
+                if (fd == listen_fd_) {
+                    AcceptConnections();
+                    continue;
+                }
+
+                // Соединение могло быть закрыто при обработке предыдущего события
+                auto it = connections_.find(fd);
+                if (it == connections_.end()) {
+                    continue;
+                }
+                Connection& connection = it->second;
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    ReadFrom(fd, connection);
+                }
+                else if (events[i].events & EPOLLOUT) {
+                    WriteTo(fd, connection);
+                }
+            }
+        }
+
+        sigaction(SIGINT, &old_int, nullptr);
+        sigaction(SIGTERM, &old_term, nullptr);
+        stop_pipe_write_fd = -1;
+        close(stop_pipe[0]);
+        close(stop_pipe[1]);
+    }
+
+    void UnixSocketServer::AcceptConnections() {
+        while (true) {
+            const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                // Кроме EAGAIN (очередь пуста) это нехватка дескрипторов или
+                // памяти. Соединение остаётся в очереди, и epoll сразу сообщил бы
+                // о нём снова, поэтому сокет приёма на время снимается с ожидания
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    SetAccepting(false);
+                }
+                return;
+            }
+
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+                close(fd);
+                SetAccepting(false);
+                return;
+            }
+            connections_.emplace(fd, Connection{});
+        }
+    }
+
+    void UnixSocketServer::SetAccepting(bool accepting) {
+        if (!accepting) {
+            accept_retry_at_ = std::chrono::steady_clock::now() + ACCEPT_RETRY_DELAY;
+        }
+        if (accepting_ == accepting) {
+            return;
+        }
+        accepting_ = accepting;
+        epoll_event event{};
+        event.events = 0;
+        if (accepting) {
+            event.events |= EPOLLIN;
+        }
+        event.data.fd = listen_fd_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, listen_fd_, &event);
+    }
+
+    bool UnixSocketServer::IsOutputFull(const Connection& connection) {
+        return connection.output.size() - connection.written >= MAX_PENDING_OUTPUT;
+    }
+
+    void UnixSocketServer::ReadFrom(int fd, Connection& connection) {
+        // Чтение прекращается, как только ответов накопилось больше предела;
+        // необработанные строки останутся в input до отправки ответов
+        char chunk[1 << 16];
+        while (!connection.input_closed && !IsOutputFull(connection)) {
+            const ssize_t size = recv(fd, chunk, sizeof(chunk), 0);
+            if (size > 0) {
+                connection.input.append(chunk, static_cast<size_t>(size));
+                HandleInput(connection);
+                if (connection.input.size() > MAX_LINE_SIZE && connection.input.find('\n') == std::string::npos) {
+                    CloseConnection(fd);
+                    return;
+                }
+                continue;
+            }
+            if (size == 0) {
+                connection.input_closed = true;
+                HandleInput(connection);
+            }
+            else if (errno == EINTR) {
+                continue;
+            }
+            else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                CloseConnection(fd);
+                return;
+            }
+            break;
+        }
+
+        WriteTo(fd, connection);
+    }
+
+    void UnixSocketServer::HandleInput(Connection& connection) {
+        size_t line_begin = 0;
+        while (!IsOutputFull(connection)) {
+            const size_t line_end = connection.input.find('\n', line_begin);
+            if (line_end == std::string::npos) {
+                break;
+            }
+            std::string_view line(connection.input.data() + line_begin, line_end - line_begin);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (!line.empty()) {
+                connection.output += handler_(line);
+                connection.output += '\n';
+            }
+            line_begin = line_end + 1;
+        }
+        connection.input.erase(0, line_begin);
+
+        if (connection.input_closed && !connection.input.empty() && !IsOutputFull(connection)) {
+            // Последняя строка может прийти без перевода строки
+            connection.output += handler_(connection.input);
+            connection.output += '\n';
+            connection.input.clear();
+        }
+    }
+
+    void UnixSocketServer::WriteTo(int fd, Connection& connection) {
+        while (true) {
+            while (connection.written < connection.output.size()) {
+                const ssize_t size = send(fd, connection.output.data() + connection.written,
+                    connection.output.size() - connection.written, MSG_NOSIGNAL);
+                if (size > 0) {
+                    connection.written += static_cast<size_t>(size);
+                    continue;
+                }
+                if (size < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    break;
+                }
+                CloseConnection(fd);
+                return;
+            }
+            if (connection.written < connection.output.size()) {
+                break;
+            }
+            connection.output.clear();
+            connection.written = 0;
+
+            // Ответы отправлены: очередь отложенных строк можно обработать
+            if (connection.input.empty()) {
+                break;
+            }
+            HandleInput(connection);
+            if (connection.output.empty()) {
+                break;
+            }
+        }
+
+        if (connection.input_closed && connection.input.empty() && connection.output.empty()) {
+            CloseConnection(fd);
+            return;
+        }
+        UpdateEvents(fd, connection);
+    }
+
+    void UnixSocketServer::UpdateEvents(int fd, const Connection& connection) {
+        epoll_event event{};
+        event.events = 0;
+        if (!connection.input_closed && !IsOutputFull(connection)) {
+            event.events |= EPOLLIN;
+        }
+        if (!connection.output.empty()) {
+            event.events |= EPOLLOUT;
+        }
+        event.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+    }
+
+    void UnixSocketServer::CloseConnection(int fd) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections_.erase(fd);
+        // Освободившийся дескриптор может принять ожидающее соединение
+        SetAccepting(true);
+    }
+
+}  // namespace server
\ No newline at end of file
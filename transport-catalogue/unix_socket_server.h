@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace server {
+
+    // Однопоточный сервер на Unix-сокете с циклом событий epoll. Клиент
+    // присылает запросы по одному в строке (NDJSON), на каждую строку
+    // приходит одна строка ответа в том же порядке. Run работает до SIGINT
+    // или SIGTERM, после чего закрывает соединения и удаляет файл сокета
+    class UnixSocketServer {
+    public:
+        // Получает строку без завершающего перевода строки, возвращает ответ без него
+        using LineHandler = std::function<std::string(std::string_view)>;
+
+        UnixSocketServer(std::string socket_path, LineHandler handler);
+
+        UnixSocketServer(const UnixSocketServer&) = delete;
+        UnixSocketServer& operator=(const UnixSocketServer&) = delete;
+
+        ~UnixSocketServer();
+
+        void Run();
+
+    private:
+        struct Connection {
+            std::string input;
+            std::string output;
+            // Сколько байт output уже отправлено
+            size_t written = 0;
+            bool input_closed = false;
+        };
+
+        // Не даём одной строке без перевода строки занять всю память
+        static constexpr size_t MAX_LINE_SIZE = 64 << 20;
+        // Клиент, который шлёт запросы, не читая ответы, не должен копить их
+        // без предела: пока неотправленных ответов больше, соединение не читается
+        static constexpr size_t MAX_PENDING_OUTPUT = 64 << 20;
+
+        // Пока приём приостановлен из-за нехватки дескрипторов, он повторяется
+        // при закрытии соединения или спустя это время
+        static constexpr std::chrono::milliseconds ACCEPT_RETRY_DELAY{ 100 };
+
+        static bool IsOutputFull(const Connection& connection);
+
+        void AcceptConnections();
+        void SetAccepting(bool accepting);
+        void ReadFrom(int fd, Connection& connection);
+        void HandleInput(Connection& connection);
+        void WriteTo(int fd, Connection& connection);
+        void UpdateEvents(int fd, const Connection& connection);
+        void CloseConnection(int fd);
+
+        std::string socket_path_;
+        LineHandler handler_;
+        int listen_fd_ = -1;
+        int epoll_fd_ = -1;
+        int signal_fd_ = -1;
+        bool accepting_ = true;
+        std::chrono::steady_clock::time_point accept_retry_at_;
+        std::unordered_map<int, Connection> connections_;
+    };
+
+}  // namespace server
\ No newline at end of file